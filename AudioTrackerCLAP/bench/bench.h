@@ -0,0 +1,61 @@
+// AudioTracker micro-benchmark helpers
+// Times a kernel over repeated calls and prints one line per case. Built and
+// run by `make bench`; each benchmark is a standalone program that includes
+// only the headers it measures, so no CLAP SDK or libcurl is needed.
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace bench {
+
+// Best of `runs` timings, each averaged over enough calls to last ~20 ms
+template <typename Fn>
+double nanosPerCall(Fn&& fn, int runs = 5) {
+    using Clock = std::chrono::steady_clock;
+
+    uint64_t calls = 1;
+    for (;;) {
+        const auto start = Clock::now();
+        for (uint64_t i = 0; i < calls; ++i) fn();
+        if (Clock::now() - start >= std::chrono::milliseconds(20)) break;
+        calls *= 2;
+    }
+
+    double best = 1e300;
+    for (int run = 0; run < runs; ++run) {
+        const auto start = Clock::now();
+        for (uint64_t i = 0; i < calls; ++i) fn();
+        const std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+        best = std::min(best, elapsed.count() / static_cast<double>(calls));
+    }
+    return best;
+}
+
+// Deterministic noise in [-1, 1)
+inline std::vector<float> noise(size_t count, uint32_t seed = 1) {
+    std::vector<float> samples(count);
+    for (float& sample : samples) {
+        seed = seed * 1664525u + 1013904223u;
+        sample = static_cast<float>(seed >> 8) / 8388608.0f - 1.0f;
+    }
+    return samples;
+}
+
+// Keeps the optimizer from discarding a result
+inline volatile float sink;
+
+inline void consume(float value) {
+    sink = value;
+}
+
+inline void printRow(const char* name, uint32_t size, uint32_t lanes, double baseline, double candidate) {
+    printf("%-18s N=%-5u x%-2u %10.0f ns %10.0f ns  %5.2fx\n", name, size, lanes, baseline, candidate,
+           baseline / candidate);
+}
+
+} // namespace bench
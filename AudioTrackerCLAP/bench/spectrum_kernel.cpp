@@ -0,0 +1,110 @@
+// dsp::summarizeSpectrum against the three loops it replaced (magnitudes,
+// centroid sums, F0 peak search), at every analyzer frame size. Also checks
+// that both give the same spectrum, centroid and peak bin.
+
+#include "bench.h"
+#include "../src/fft_backend.h"
+#include "../src/spectrum_kernel.h"
+
+#include <cmath>
+
+namespace {
+
+constexpr float kSampleRate = 48000.0f;
+constexpr float kMinF0Hz = 60.0f;
+constexpr float kMaxF0Hz = 600.0f;
+
+struct Features {
+    float centroid;
+    uint32_t peakIndex;
+};
+
+// The per-frame loops AudioAnalyzer ran before the fused kernel
+Features threePass(const float* real, const float* imag, float* magnitudes, uint32_t n, float scale,
+                   uint32_t minBin, uint32_t maxBin, float freqBinWidth) {
+    for (uint32_t i = 0; i < n; ++i) {
+        magnitudes[i] = real[i] * real[i] + imag[i] * imag[i];
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+        magnitudes[i] = sqrtf(magnitudes[i] * scale);
+    }
+
+    float weightedSum = 0.0f;
+    float totalMag = 0.0f;
+    for (uint32_t i = 1; i < n; ++i) {
+        float freq = i * freqBinWidth;
+        weightedSum += freq * magnitudes[i];
+        totalMag += magnitudes[i];
+    }
+
+    float maxMag = 0.0f;
+    uint32_t maxIdx = minBin;
+    for (uint32_t i = minBin; i <= maxBin; ++i) {
+        if (magnitudes[i] > maxMag) {
+            maxMag = magnitudes[i];
+            maxIdx = i;
+        }
+    }
+
+    return { totalMag > 0.0f ? weightedSum / totalMag : 0.0f, maxIdx };
+}
+
+} // namespace
+
+int main() {
+    printf("%-18s %-11s %13s %13s  %6s\n", "spectrum", "size", "three pass", "fused", "speedup");
+    bool same = true;
+
+    for (uint32_t size = 1024; size <= 8192; size *= 2) {
+        const uint32_t half = size / 2;
+        const float freqBinWidth = kSampleRate / size;
+        const float scale = 1.0f / (size * 2);
+        const uint32_t minBin = std::clamp(static_cast<uint32_t>(kMinF0Hz / freqBinWidth), 1u, half - 2);
+        const uint32_t maxBin = std::clamp(static_cast<uint32_t>(kMaxF0Hz / freqBinWidth), minBin, half - 2);
+
+        // A windowed 220 Hz tone over noise, so the peak search has a real peak
+        std::vector<float> frame = bench::noise(size);
+        std::vector<float> window(size);
+        dsp::hannWindow(window.data(), size);
+        for (uint32_t i = 0; i < size; ++i) {
+            frame[i] = (0.1f * frame[i] + sinf(6.2831853f * 220.0f * i / kSampleRate)) * window[i];
+        }
+        std::vector<float> real(half), imag(half);
+        RealFFT fft(size);
+        fft.forward(frame.data(), real.data(), imag.data());
+
+        std::vector<float> oldMagnitudes(half), newMagnitudes(half);
+        Features old {};
+        const double baseline = bench::nanosPerCall([&] {
+            old = threePass(real.data(), imag.data(), oldMagnitudes.data(), half, scale, minBin, maxBin,
+                            freqBinWidth);
+            bench::consume(old.centroid);
+        });
+
+        dsp::SpectrumSummary summary;
+        const double fused = bench::nanosPerCall([&] {
+            summary = dsp::summarizeSpectrum(real.data(), imag.data(), newMagnitudes.data(), half, scale,
+                                             minBin, maxBin);
+            bench::consume(summary.sum);
+        });
+
+        bench::printRow("summarize", size, 1, baseline, fused);
+
+        // Summation order and FMA contraction may move the centroid slightly;
+        // the spectrum and the peak bin must not change
+        const float centroid = summary.sum > 0.0f ? freqBinWidth * summary.weightedSum / summary.sum : 0.0f;
+        float worst = 0.0f;
+        for (uint32_t i = 0; i < half; ++i) {
+            worst = std::max(worst, std::fabs(newMagnitudes[i] - oldMagnitudes[i]) /
+                                        std::max(oldMagnitudes[i], 1e-20f));
+        }
+        if (summary.peakIndex != old.peakIndex || std::fabs(centroid - old.centroid) > 1e-4f * old.centroid ||
+            worst > 1e-6f) {
+            printf("FAILED at N=%u: peak %u vs %u, centroid %.4f vs %.4f, spectrum %.2e\n", size,
+                   summary.peakIndex, old.peakIndex, centroid, old.centroid, worst);
+            same = false;
+        }
+    }
+
+    return same ? 0 : 1;
+}
@@ -0,0 +1,381 @@
+// AudioTracker FFT backend
+// Real FFT + the few vector primitives AudioAnalyzer needs, selected at build time:
+//   AUDIOTRACKER_FFT_ACCELERATE - Apple Accelerate (vDSP), default on macOS
+//   AUDIOTRACKER_FFT_PORTABLE   - built-in split-complex Stockham radix-4/2 FFT, default elsewhere
+//
+// Every backend shares the same contract so the analyzer hot path is backend-agnostic:
+//   - all memory is allocated in the constructor, forward() never allocates
+//   - forward() takes N real samples and writes N/2 split-complex bins in the
+//     vDSP_fft_zrip packed layout: real[0] = DC, imag[0] = Nyquist, and every
+//     value scaled by 2 relative to the mathematical DFT
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if !defined(AUDIOTRACKER_FFT_ACCELERATE) && !defined(AUDIOTRACKER_FFT_PORTABLE)
+#if defined(__APPLE__)
+#define AUDIOTRACKER_FFT_ACCELERATE 1
+#else
+#define AUDIOTRACKER_FFT_PORTABLE 1
+#endif
+#endif
+
+#if defined(AUDIOTRACKER_FFT_ACCELERATE) && defined(AUDIOTRACKER_FFT_PORTABLE)
+#error "Select exactly one FFT backend"
+#endif
+
+#if defined(AUDIOTRACKER_FFT_ACCELERATE)
+#include <Accelerate/Accelerate.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define AT_RESTRICT __restrict__
+#else
+#define AT_RESTRICT
+#endif
+
+#if defined(AUDIOTRACKER_FFT_ACCELERATE)
+
+// ============================================================================
+// Accelerate backend
+// ============================================================================
+
+class AccelerateFFT {
+public:
+    static constexpr const char* kName = "accelerate";
+
+    explicit AccelerateFFT(uint32_t size)
+        : size_(size),
+          log2n_(static_cast<vDSP_Length>(log2(size))) {
+        setup_ = vDSP_create_fftsetup(log2n_, FFT_RADIX2);
+    }
+
+    ~AccelerateFFT() {
+        if (setup_) {
+            vDSP_destroy_fftsetup(setup_);
+        }
+    }
+
+    AccelerateFFT(const AccelerateFFT&) = delete;
+    AccelerateFFT& operator=(const AccelerateFFT&) = delete;
+
+    uint32_t size() const { return size_; }
+
+    void forward(const float* input, float* real, float* imag) {
+        DSPSplitComplex split = { real, imag };
+        vDSP_ctoz(reinterpret_cast<const DSPComplex*>(input), 2, &split, 1, size_ / 2);
+        vDSP_fft_zrip(setup_, &split, 1, log2n_, FFT_FORWARD);
+    }
+
+private:
+    uint32_t size_;
+    vDSP_Length log2n_;
+    FFTSetup setup_ = nullptr;
+};
+
+using RealFFT = AccelerateFFT;
+
+namespace dsp {
+
+inline void hannWindow(float* out, uint32_t n) {
+    vDSP_hann_window(out, n, vDSP_HANN_NORM);
+}
+
+inline void multiply(const float* a, const float* b, float* out, uint32_t n) {
+    vDSP_vmul(a, 1, b, 1, out, 1, n);
+}
+
+inline float sumOfSquares(const float* x, uint32_t n) {
+    float sum = 0.0f;
+    vDSP_svesq(x, 1, &sum, n);
+    return sum;
+}
+
+} // namespace dsp
+
+#else
+
+// ============================================================================
+// Portable backend - Stockham autosort FFT on split-complex arrays
+// ============================================================================
+//
+// The N-point real transform runs as an N/2-point complex transform over the
+// even/odd samples followed by the usual split post-pass. The complex stages
+// are radix-4 with one trailing radix-2 stage when log2(N/2) is odd. Stockham
+// ping-pongs between two buffers instead of bit-reversing, so every butterfly
+// reads and writes unit-stride runs of the split real/imag arrays and the
+// compiler can vectorize them (SSE/AVX2/NEON) without shuffles.
+
+class PortableFFT {
+public:
+    static constexpr const char* kName = "portable";
+
+    explicit PortableFFT(uint32_t size)
+        : size_(size),
+          half_(size / 2) {
+        workRe_[0].resize(half_);
+        workIm_[0].resize(half_);
+        workRe_[1].resize(half_);
+        workIm_[1].resize(half_);
+        buildTwiddles();
+    }
+
+    PortableFFT(const PortableFFT&) = delete;
+    PortableFFT& operator=(const PortableFFT&) = delete;
+
+    uint32_t size() const { return size_; }
+
+    void forward(const float* input, float* real, float* imag) {
+        float* AT_RESTRICT zr = workRe_[0].data();
+        float* AT_RESTRICT zi = workIm_[0].data();
+
+        // Pack even/odd samples as one complex signal of length N/2
+        for (uint32_t k = 0; k < half_; ++k) {
+            zr[k] = input[2 * k];
+            zi[k] = input[2 * k + 1];
+        }
+
+        const int result = transformComplex();
+        splitRealSpectrum(workRe_[result].data(), workIm_[result].data(), real, imag);
+    }
+
+private:
+    struct Stage {
+        uint32_t radix;
+        uint32_t n;       // sub-transform length at this stage
+        uint32_t stride;  // number of interleaved sub-transforms
+        uint32_t twiddleOffset;
+    };
+
+    void buildTwiddles() {
+        const double twoPi = 6.283185307179586476925286766559;
+
+        uint32_t n = half_;
+        uint32_t stride = 1;
+        uint32_t offset = 0;
+
+        while (n > 1) {
+            const uint32_t radix = (n % 4 == 0) ? 4 : 2;
+            const uint32_t m = n / radix;
+            stages_.push_back({ radix, n, stride, offset });
+
+            // w^p, w^2p, w^3p for radix 4; radix 2 only needs w^p
+            for (uint32_t r = 1; r < radix; ++r) {
+                for (uint32_t p = 0; p < m; ++p) {
+                    double angle = -twoPi * static_cast<double>(r * p) / n;
+                    twiddleRe_.push_back(static_cast<float>(cos(angle)));
+                    twiddleIm_.push_back(static_cast<float>(sin(angle)));
+                }
+            }
+            offset += (radix - 1) * m;
+
+            n = m;
+            stride *= radix;
+        }
+
+        // Post-pass twiddles e^(-2*pi*i*k/N) for k in [0, N/4]
+        postCos_.resize(half_ / 2 + 1);
+        postSin_.resize(half_ / 2 + 1);
+        for (uint32_t k = 0; k <= half_ / 2; ++k) {
+            double angle = twoPi * static_cast<double>(k) / size_;
+            postCos_[k] = static_cast<float>(cos(angle));
+            postSin_[k] = static_cast<float>(sin(angle));
+        }
+    }
+
+    // Runs all stages, returns the index of the buffer holding the result
+    int transformComplex() {
+        int src = 0;
+        for (const Stage& stage : stages_) {
+            const int dst = src ^ 1;
+            if (stage.radix == 4) {
+                radix4(stage, workRe_[src].data(), workIm_[src].data(),
+                       workRe_[dst].data(), workIm_[dst].data());
+            } else {
+                radix2(stage, workRe_[src].data(), workIm_[src].data(),
+                       workRe_[dst].data(), workIm_[dst].data());
+            }
+            src = dst;
+        }
+        return src;
+    }
+
+    void radix4(const Stage& st,
+                const float* AT_RESTRICT xr, const float* AT_RESTRICT xi,
+                float* AT_RESTRICT yr, float* AT_RESTRICT yi) const {
+        const uint32_t m = st.n / 4;
+        const uint32_t s = st.stride;
+        const float* w1r = twiddleRe_.data() + st.twiddleOffset;
+        const float* w1i = twiddleIm_.data() + st.twiddleOffset;
+        const float* w2r = w1r + m;
+        const float* w2i = w1i + m;
+        const float* w3r = w2r + m;
+        const float* w3i = w2i + m;
+
+        for (uint32_t p = 0; p < m; ++p) {
+            const float c1 = w1r[p], s1 = w1i[p];
+            const float c2 = w2r[p], s2 = w2i[p];
+            const float c3 = w3r[p], s3 = w3i[p];
+
+            // Inputs are the four quarters of the current sub-transform, outputs
+            // four consecutive runs of `s` - both unit stride in q
+            const size_t in = static_cast<size_t>(s) * p;
+            const size_t quarter = static_cast<size_t>(s) * m;
+            const float* AT_RESTRICT aRe = xr + in;
+            const float* AT_RESTRICT aIm = xi + in;
+            const float* AT_RESTRICT bRe = aRe + quarter;
+            const float* AT_RESTRICT bIm = aIm + quarter;
+            const float* AT_RESTRICT cRe = bRe + quarter;
+            const float* AT_RESTRICT cIm = bIm + quarter;
+            const float* AT_RESTRICT dRe = cRe + quarter;
+            const float* AT_RESTRICT dIm = cIm + quarter;
+
+            const size_t out = static_cast<size_t>(s) * 4 * p;
+            float* AT_RESTRICT y0r = yr + out;
+            float* AT_RESTRICT y0i = yi + out;
+            float* AT_RESTRICT y1r = y0r + s;
+            float* AT_RESTRICT y1i = y0i + s;
+            float* AT_RESTRICT y2r = y1r + s;
+            float* AT_RESTRICT y2i = y1i + s;
+            float* AT_RESTRICT y3r = y2r + s;
+            float* AT_RESTRICT y3i = y2i + s;
+
+            for (size_t q = 0; q < s; ++q) {
+                const float apcR = aRe[q] + cRe[q], apcI = aIm[q] + cIm[q];
+                const float amcR = aRe[q] - cRe[q], amcI = aIm[q] - cIm[q];
+                const float bpdR = bRe[q] + dRe[q], bpdI = bIm[q] + dIm[q];
+                // -i * (b - d)
+                const float jbmdR = bIm[q] - dIm[q], jbmdI = dRe[q] - bRe[q];
+
+                y0r[q] = apcR + bpdR;
+                y0i[q] = apcI + bpdI;
+
+                const float t1R = amcR + jbmdR, t1I = amcI + jbmdI;
+                y1r[q] = t1R * c1 - t1I * s1;
+                y1i[q] = t1R * s1 + t1I * c1;
+
+                const float t2R = apcR - bpdR, t2I = apcI - bpdI;
+                y2r[q] = t2R * c2 - t2I * s2;
+                y2i[q] = t2R * s2 + t2I * c2;
+
+                const float t3R = amcR - jbmdR, t3I = amcI - jbmdI;
+                y3r[q] = t3R * c3 - t3I * s3;
+                y3i[q] = t3R * s3 + t3I * c3;
+            }
+        }
+    }
+
+    void radix2(const Stage& st,
+                const float* AT_RESTRICT xr, const float* AT_RESTRICT xi,
+                float* AT_RESTRICT yr, float* AT_RESTRICT yi) const {
+        const uint32_t m = st.n / 2;
+        const uint32_t s = st.stride;
+        const float* wr = twiddleRe_.data() + st.twiddleOffset;
+        const float* wi = twiddleIm_.data() + st.twiddleOffset;
+
+        for (uint32_t p = 0; p < m; ++p) {
+            const float c = wr[p], sn = wi[p];
+
+            const size_t in = static_cast<size_t>(s) * p;
+            const size_t half = static_cast<size_t>(s) * m;
+            const float* AT_RESTRICT aRe = xr + in;
+            const float* AT_RESTRICT aIm = xi + in;
+            const float* AT_RESTRICT bRe = aRe + half;
+            const float* AT_RESTRICT bIm = aIm + half;
+
+            const size_t out = static_cast<size_t>(s) * 2 * p;
+            float* AT_RESTRICT y0r = yr + out;
+            float* AT_RESTRICT y0i = yi + out;
+            float* AT_RESTRICT y1r = y0r + s;
+            float* AT_RESTRICT y1i = y0i + s;
+
+            for (size_t q = 0; q < s; ++q) {
+                y0r[q] = aRe[q] + bRe[q];
+                y0i[q] = aIm[q] + bIm[q];
+                const float dR = aRe[q] - bRe[q], dI = aIm[q] - bIm[q];
+                y1r[q] = dR * c - dI * sn;
+                y1i[q] = dR * sn + dI * c;
+            }
+        }
+    }
+
+    // Z = FFT(even + i*odd) -> 2*X[k] for k in [0, N/2), Nyquist packed in imag[0]
+    void splitRealSpectrum(const float* AT_RESTRICT zr, const float* AT_RESTRICT zi,
+                           float* AT_RESTRICT real, float* AT_RESTRICT imag) const {
+        real[0] = 2.0f * (zr[0] + zi[0]);
+        imag[0] = 2.0f * (zr[0] - zi[0]);
+
+        for (uint32_t k = 1; k <= half_ / 2; ++k) {
+            const uint32_t j = half_ - k;
+
+            // s = Z[k] + conj(Z[j]), d = Z[k] - conj(Z[j])
+            const float sR = zr[k] + zr[j], sI = zi[k] - zi[j];
+            const float dR = zr[k] - zr[j], dI = zi[k] + zi[j];
+            const float c = postCos_[k], sn = postSin_[k];
+
+            // 2X[k] = s - i * e^(-2*pi*i*k/N) * d
+            const float tR = sn * dR - c * dI;
+            const float tI = sn * dI + c * dR;
+            real[k] = sR - tR;
+            imag[k] = sI - tI;
+
+            // 2X[N/2-k] = conj(s + t), so the mirrored bin reuses the same twiddle
+            real[j] = sR + tR;
+            imag[j] = -(sI + tI);
+        }
+    }
+
+    uint32_t size_;
+    uint32_t half_;
+
+    std::vector<Stage> stages_;
+    std::vector<float> twiddleRe_;
+    std::vector<float> twiddleIm_;
+    std::vector<float> postCos_;
+    std::vector<float> postSin_;
+    std::vector<float> workRe_[2];
+    std::vector<float> workIm_[2];
+};
+
+using RealFFT = PortableFFT;
+
+namespace dsp {
+
+// Matches vDSP_hann_window(..., vDSP_HANN_NORM)
+inline void hannWindow(float* out, uint32_t n) {
+    const double twoPi = 6.283185307179586476925286766559;
+    for (uint32_t i = 0; i < n; ++i) {
+        out[i] = static_cast<float>(0.8165 * (1.0 - cos(twoPi * i / n)));
+    }
+}
+
+inline void multiply(const float* AT_RESTRICT a, const float* AT_RESTRICT b,
+                     float* AT_RESTRICT out, uint32_t n) {
+    for (uint32_t i = 0; i < n; ++i) {
+        out[i] = a[i] * b[i];
+    }
+}
+
+inline float sumOfSquares(const float* AT_RESTRICT x, uint32_t n) {
+    // Four partial sums so the reduction vectorizes without -ffast-math
+    float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+    uint32_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += x[i] * x[i];
+        s1 += x[i + 1] * x[i + 1];
+        s2 += x[i + 2] * x[i + 2];
+        s3 += x[i + 3] * x[i + 3];
+    }
+    for (; i < n; ++i) {
+        s0 += x[i] * x[i];
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
+} // namespace dsp
+
+#endif
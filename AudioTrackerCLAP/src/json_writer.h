@@ -0,0 +1,126 @@
+// AudioTracker JSON writer
+// Appends JSON tokens to a buffer allocated once at construction. Numbers go
+// through std::to_chars, so serializing never allocates, never touches the
+// locale and never goes through iostreams.
+
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+class JsonWriter {
+public:
+    static constexpr int MAX_PRECISION = 6;
+
+    explicit JsonWriter(size_t capacity) : buffer_(capacity) {}
+
+    void clear() { size_ = 0; }
+
+    const char* data() const { return buffer_.data(); }
+    size_t size() const { return size_; }
+    size_t capacity() const { return buffer_.size(); }
+    size_t remaining() const { return buffer_.size() - size_; }
+
+    // Callers size their writes against remaining(); anything past capacity is
+    // truncated rather than reallocated
+    void raw(char c) {
+        if (size_ < buffer_.size()) buffer_[size_++] = c;
+    }
+
+    void raw(const char* text, size_t length) {
+        length = std::min(length, remaining());
+        memcpy(buffer_.data() + size_, text, length);
+        size_ += length;
+    }
+
+    void raw(const char* text) { raw(text, strlen(text)); }
+
+    // Writes "name": - names are plain identifiers and are not escaped
+    void key(const char* name) {
+        raw('"');
+        raw(name);
+        raw("\":", 2);
+    }
+
+    void value(uint64_t v) {
+        char tmp[24];
+        auto result = std::to_chars(tmp, tmp + sizeof(tmp), v);
+        raw(tmp, static_cast<size_t>(result.ptr - tmp));
+    }
+
+    void value(int64_t v) {
+        char tmp[24];
+        auto result = std::to_chars(tmp, tmp + sizeof(tmp), v);
+        raw(tmp, static_cast<size_t>(result.ptr - tmp));
+    }
+
+    // Fixed notation with `precision` decimals (0..MAX_PRECISION). Formatted as
+    // an integer count of 10^-precision units, since floating-point to_chars
+    // is missing from some standard libraries (libc++ on macOS) and snprintf
+    // follows LC_NUMERIC. The scaled float is exact in a double, so rounding
+    // it to nearest-even gives printf's digits. NaN/inf are not valid JSON and
+    // become null, as do magnitudes too large for 64 bits once scaled.
+    void value(float v, int precision = 2) {
+        static constexpr uint64_t scales[MAX_PRECISION + 1] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+        precision = std::clamp(precision, 0, MAX_PRECISION);
+
+        const double scaled = std::nearbyint(std::fabs(static_cast<double>(v)) * static_cast<double>(scales[precision]));
+        if (!std::isfinite(v) || !(scaled < 1.8e19)) {
+            raw("null", 4);
+            return;
+        }
+
+        const uint64_t units = static_cast<uint64_t>(scaled);
+        if (v < 0.0f && units != 0) raw('-');
+        value(units / scales[precision]);
+        if (precision == 0) return;
+
+        // Fraction digits, zero-padded to `precision`
+        char digits[MAX_PRECISION];
+        uint64_t fraction = units % scales[precision];
+        for (int i = precision - 1; i >= 0; --i) {
+            digits[i] = static_cast<char>('0' + fraction % 10);
+            fraction /= 10;
+        }
+        raw('.');
+        raw(digits, static_cast<size_t>(precision));
+    }
+
+    // Playhead seconds as a quoted "HH:MM:SS.mmm" string
+    void timestamp(double seconds) {
+        if (!(seconds > 0.0)) seconds = 0.0;
+
+        uint64_t totalMillis = static_cast<uint64_t>(seconds * 1000.0);
+        uint64_t millis = totalMillis % 1000;
+        uint64_t totalSecs = totalMillis / 1000;
+        uint64_t secs = totalSecs % 60;
+        uint64_t mins = (totalSecs / 60) % 60;
+        uint64_t hours = totalSecs / 3600;
+
+        raw('"');
+        if (hours < 10) raw('0');
+        value(hours);
+        raw(':');
+        twoDigits(static_cast<unsigned>(mins));
+        raw(':');
+        twoDigits(static_cast<unsigned>(secs));
+        raw('.');
+        raw(static_cast<char>('0' + millis / 100));
+        raw(static_cast<char>('0' + (millis / 10) % 10));
+        raw(static_cast<char>('0' + millis % 10));
+        raw('"');
+    }
+
+private:
+    void twoDigits(unsigned v) {
+        raw(static_cast<char>('0' + v / 10));
+        raw(static_cast<char>('0' + v % 10));
+    }
+
+    std::vector<char> buffer_;
+    size_t size_ = 0;
+};
@@ -1,552 +1,2009 @@
-// AudioTracker CLAP Plugin
-// Real-time audio analysis with FFT, pitch detection, and metrics posting
-
-#include <clap/clap.h>
-#include <Accelerate/Accelerate.h>
-#include <curl/curl.h>
-
-#include <cmath>
-#include <cstring>
-#include <vector>
-#include <string>
-#include <thread>
-#include <mutex>
-#include <condition_variable>
-#include <atomic>
-#include <queue>
-#include <chrono>
-#include <sstream>
-#include <iomanip>
-
-// Plugin constants
-static constexpr uint32_t FFT_SIZE = 4096;
-static constexpr uint32_t FFT_SIZE_HALF = FFT_SIZE / 2;
-static constexpr float SILENCE_THRESHOLD_DB = -50.0f;
-static constexpr float MIN_F0_HZ = 60.0f;
-static constexpr float MAX_F0_HZ = 600.0f;
-static constexpr const char* API_URL = "http://localhost:9091/api/audio";
-
-// ============================================================================
-// Audio Analyzer - all buffers pre-allocated
-// ============================================================================
-
-class AudioAnalyzer {
-public:
-    AudioAnalyzer() {
-        fftLog2n_ = static_cast<vDSP_Length>(log2(FFT_SIZE));
-        fftSetup_ = vDSP_create_fftsetup(fftLog2n_, FFT_RADIX2);
-
-        window_.resize(FFT_SIZE);
-        inputBuffer_.resize(FFT_SIZE);
-        windowed_.resize(FFT_SIZE);
-        fftReal_.resize(FFT_SIZE_HALF);
-        fftImag_.resize(FFT_SIZE_HALF);
-        magnitudes_.resize(FFT_SIZE_HALF);
-
-        vDSP_hann_window(window_.data(), FFT_SIZE, vDSP_HANN_NORM);
-    }
-
-    ~AudioAnalyzer() {
-        if (fftSetup_) {
-            vDSP_destroy_fftsetup(fftSetup_);
-        }
-    }
-
-    void setSampleRate(float sr) { sampleRate_ = sr; }
-    float getSampleRate() const { return sampleRate_; }
-
-    bool addSamples(const float* samples, uint32_t count) {
-        uint32_t toCopy = std::min(count, FFT_SIZE - bufferPos_);
-        memcpy(inputBuffer_.data() + bufferPos_, samples, toCopy * sizeof(float));
-        bufferPos_ += toCopy;
-        return bufferPos_ >= FFT_SIZE;
-    }
-
-    uint32_t getSamplesNeeded() const {
-        return FFT_SIZE - bufferPos_;
-    }
-
-    void resetBuffer() { bufferPos_ = 0; }
-    uint32_t getBufferPos() const { return bufferPos_; }
-
-    float computeRMS() const {
-        float sumSquares = 0.0f;
-        vDSP_svesq(inputBuffer_.data(), 1, &sumSquares, FFT_SIZE);
-        float rms = sqrtf(sumSquares / FFT_SIZE);
-        return 20.0f * log10f(fmaxf(rms, 1e-10f));
-    }
-
-    void computeFFT() {
-        vDSP_vmul(inputBuffer_.data(), 1, window_.data(), 1, windowed_.data(), 1, FFT_SIZE);
-
-        DSPSplitComplex split = { fftReal_.data(), fftImag_.data() };
-        vDSP_ctoz(reinterpret_cast<const DSPComplex*>(windowed_.data()), 2, &split, 1, FFT_SIZE_HALF);
-
-        vDSP_fft_zrip(fftSetup_, &split, 1, fftLog2n_, FFT_FORWARD);
-        vDSP_zvmags(&split, 1, magnitudes_.data(), 1, FFT_SIZE_HALF);
-
-        float scale = 1.0f / (FFT_SIZE * 2);
-        for (uint32_t i = 0; i < FFT_SIZE_HALF; ++i) {
-            magnitudes_[i] = sqrtf(magnitudes_[i] * scale);
-        }
-    }
-
-    float computeSpectralCentroid() const {
-        float freqBinWidth = sampleRate_ / FFT_SIZE;
-        float weightedSum = 0.0f;
-        float totalMag = 0.0f;
-
-        for (uint32_t i = 1; i < FFT_SIZE_HALF; ++i) {
-            float freq = i * freqBinWidth;
-            weightedSum += freq * magnitudes_[i];
-            totalMag += magnitudes_[i];
-        }
-
-        return totalMag > 0.0f ? weightedSum / totalMag : 0.0f;
-    }
-
-    float detectF0() const {
-        float freqBinWidth = sampleRate_ / FFT_SIZE;
-        uint32_t minBin = static_cast<uint32_t>(MIN_F0_HZ / freqBinWidth);
-        uint32_t maxBin = static_cast<uint32_t>(MAX_F0_HZ / freqBinWidth);
-        maxBin = std::min(maxBin, FFT_SIZE_HALF - 1);
-
-        float maxMag = 0.0f;
-        uint32_t maxIdx = minBin;
-
-        for (uint32_t i = minBin; i <= maxBin; ++i) {
-            if (magnitudes_[i] > maxMag) {
-                maxMag = magnitudes_[i];
-                maxIdx = i;
-            }
-        }
-
-        if (maxMag < 0.001f) return 0.0f;
-        return maxIdx * freqBinWidth;
-    }
-
-private:
-    float sampleRate_ = 44100.0f;
-    FFTSetup fftSetup_ = nullptr;
-    vDSP_Length fftLog2n_ = 0;
-
-    std::vector<float> window_;
-    std::vector<float> inputBuffer_;
-    std::vector<float> windowed_;
-    std::vector<float> fftReal_;
-    std::vector<float> fftImag_;
-    std::vector<float> magnitudes_;
-
-    uint32_t bufferPos_ = 0;
-};
-
-// ============================================================================
-// Streamer - independent timer thread that streams metrics regardless of process()
-// ============================================================================
-
-class MetricsStreamer {
-public:
-    MetricsStreamer() : running_(true) {
-        streamerThread_ = std::thread(&MetricsStreamer::streamerLoop, this);
-    }
-
-    ~MetricsStreamer() {
-        running_ = false;
-        if (streamerThread_.joinable()) {
-            streamerThread_.join();
-        }
-    }
-
-    // Called from audio thread to update current metrics
-    void updateMetrics(float f0, float centroid, float rms, double playhead) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        currentF0_ = f0;
-        currentCentroid_ = centroid;
-        currentRms_ = rms;
-        currentPlayhead_ = playhead;
-        hasData_ = true;
-    }
-
-    static std::string formatTimestamp(double seconds) {
-        int hours = static_cast<int>(seconds) / 3600;
-        int mins = (static_cast<int>(seconds) % 3600) / 60;
-        int secs = static_cast<int>(seconds) % 60;
-        int millis = static_cast<int>((seconds - floor(seconds)) * 1000);
-
-        std::ostringstream ss;
-        ss << std::setfill('0');
-        ss << std::setw(2) << hours << ":";
-        ss << std::setw(2) << mins << ":";
-        ss << std::setw(2) << secs << ".";
-        ss << std::setw(3) << millis;
-        return ss.str();
-    }
-
-private:
-    void streamerLoop() {
-        // Initialize CURL for this thread
-        CURL* curl = curl_easy_init();
-        struct curl_slist* headers = nullptr;
-        if (curl) {
-            headers = curl_slist_append(headers, "Content-Type: application/json");
-        }
-
-        while (running_) {
-            // Sleep for streaming interval
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-
-            if (!running_) break;
-
-            // Get current metrics
-            float f0, centroid, rms;
-            double playhead;
-            bool hasData;
-            {
-                std::lock_guard<std::mutex> lock(mutex_);
-                f0 = currentF0_;
-                centroid = currentCentroid_;
-                rms = currentRms_;
-                playhead = currentPlayhead_;
-                hasData = hasData_;
-            }
-
-            if (!hasData || !curl) continue;
-
-            // Build JSON payload
-            std::ostringstream json;
-            json << std::fixed << std::setprecision(2);
-            json << "{";
-            json << "\"f0\":" << f0 << ",";
-            json << "\"centroid\":" << centroid << ",";
-            json << "\"rms\":" << rms << ",";
-            json << "\"startedAt\":\"" << formatTimestamp(playhead) << "\",";
-            json << "\"endedAt\":\"" << formatTimestamp(playhead) << "\",";
-            json << "\"localTime\":" << std::chrono::duration_cast<std::chrono::milliseconds>(
-                std::chrono::system_clock::now().time_since_epoch()).count();
-            json << "}";
-
-            std::string payload = json.str();
-
-            // Send request
-            curl_easy_setopt(curl, CURLOPT_URL, API_URL);
-            curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-            curl_easy_setopt(curl, CURLOPT_POSTFIELDS, payload.c_str());
-            curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, 100L);
-            curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, 50L);
-            curl_easy_perform(curl);
-        }
-
-        if (headers) curl_slist_free_all(headers);
-        if (curl) curl_easy_cleanup(curl);
-    }
-
-    std::thread streamerThread_;
-    std::mutex mutex_;
-    std::atomic<bool> running_;
-
-    float currentF0_ = 0.0f;
-    float currentCentroid_ = 0.0f;
-    float currentRms_ = -100.0f;
-    double currentPlayhead_ = 0.0;
-    bool hasData_ = false;
-};
-
-// ============================================================================
-// Plugin State
-// ============================================================================
-
-struct PluginState {
-    AudioAnalyzer analyzer;
-    MetricsStreamer streamer;  // Independent timer-based streamer
-
-    float sampleRate = 44100.0f;
-    double playheadPosition = 0.0;
-
-    // Current frame metrics
-    float currentF0 = 0.0f;
-    float currentCentroid = 0.0f;
-    float currentRms = -100.0f;
-
-    // Pre-allocated mono buffer
-    std::vector<float> monoBuffer;
-
-    void reset() {
-        currentF0 = 0.0f;
-        currentCentroid = 0.0f;
-        currentRms = -100.0f;
-        analyzer.resetBuffer();
-    }
-
-    void ensureMonoBuffer(uint32_t size) {
-        if (monoBuffer.size() < size) {
-            monoBuffer.resize(size);
-        }
-    }
-};
-
-// ============================================================================
-// CLAP Plugin Implementation
-// ============================================================================
-
-static const clap_plugin_descriptor_t pluginDescriptor = {
-    .clap_version = CLAP_VERSION,
-    .id = "com.audiotracker.clap",
-    .name = "AudioTracker",
-    .vendor = "AudioTracker",
-    .url = "https://github.com/murr/audio-tracker",
-    .manual_url = nullptr,
-    .support_url = nullptr,
-    .version = "1.0.0",
-    .description = "Real-time audio analysis and metrics tracking",
-    .features = (const char*[]){
-        CLAP_PLUGIN_FEATURE_AUDIO_EFFECT,
-        CLAP_PLUGIN_FEATURE_ANALYZER,
-        CLAP_PLUGIN_FEATURE_UTILITY,
-        nullptr
-    }
-};
-
-static bool plugin_init(const clap_plugin_t* plugin);
-static void plugin_destroy(const clap_plugin_t* plugin);
-static bool plugin_activate(const clap_plugin_t* plugin, double sampleRate, uint32_t minFrames, uint32_t maxFrames);
-static void plugin_deactivate(const clap_plugin_t* plugin);
-static bool plugin_start_processing(const clap_plugin_t* plugin);
-static void plugin_stop_processing(const clap_plugin_t* plugin);
-static void plugin_reset(const clap_plugin_t* plugin);
-static clap_process_status plugin_process(const clap_plugin_t* plugin, const clap_process_t* process);
-static const void* plugin_get_extension(const clap_plugin_t* plugin, const char* id);
-static void plugin_on_main_thread(const clap_plugin_t* plugin);
-
-// Audio ports extension
-static uint32_t audio_ports_count(const clap_plugin_t* /*plugin*/, bool /*isInput*/) {
-    return 1;
-}
-
-static bool audio_ports_get(const clap_plugin_t* /*plugin*/, uint32_t index, bool isInput, clap_audio_port_info_t* info) {
-    if (index != 0) return false;
-
-    info->id = isInput ? 0 : 1;
-    snprintf(info->name, sizeof(info->name), "%s", isInput ? "Input" : "Output");
-    info->flags = CLAP_AUDIO_PORT_IS_MAIN;
-    info->channel_count = 2;
-    info->port_type = CLAP_PORT_STEREO;
-    info->in_place_pair = isInput ? 1 : 0;
-
-    return true;
-}
-
-static const clap_plugin_audio_ports_t audioPortsExtension = {
-    .count = audio_ports_count,
-    .get = audio_ports_get
-};
-
-// Tail extension - report infinite tail so we're always processed
-static uint32_t tail_get(const clap_plugin_t* /*plugin*/) {
-    return UINT32_MAX;  // Infinite tail - never stop processing us
-}
-
-static const clap_plugin_tail_t tailExtension = {
-    .get = tail_get
-};
-
-static bool plugin_init(const clap_plugin_t* plugin) {
-    curl_global_init(CURL_GLOBAL_DEFAULT);
-    auto* state = new PluginState();
-    const_cast<clap_plugin_t*>(plugin)->plugin_data = state;
-    return true;
-}
-
-static void plugin_destroy(const clap_plugin_t* plugin) {
-    auto* state = static_cast<PluginState*>(plugin->plugin_data);
-    delete state;
-    curl_global_cleanup();
-}
-
-static bool plugin_activate(const clap_plugin_t* plugin, double sampleRate, uint32_t /*minFrames*/, uint32_t maxFrames) {
-    auto* state = static_cast<PluginState*>(plugin->plugin_data);
-    state->sampleRate = static_cast<float>(sampleRate);
-    state->analyzer.setSampleRate(state->sampleRate);
-    state->monoBuffer.resize(maxFrames);
-    return true;
-}
-
-static void plugin_deactivate(const clap_plugin_t* /*plugin*/) {
-}
-
-static bool plugin_start_processing(const clap_plugin_t* plugin) {
-    auto* state = static_cast<PluginState*>(plugin->plugin_data);
-    state->reset();
-    return true;
-}
-
-static void plugin_stop_processing(const clap_plugin_t* /*plugin*/) {
-}
-
-static void plugin_reset(const clap_plugin_t* plugin) {
-    auto* state = static_cast<PluginState*>(plugin->plugin_data);
-    state->reset();
-}
-
-static clap_process_status plugin_process(const clap_plugin_t* plugin, const clap_process_t* process) {
-    auto* state = static_cast<PluginState*>(plugin->plugin_data);
-
-    const uint32_t frameCount = process->frames_count;
-    if (frameCount == 0) {
-        return CLAP_PROCESS_CONTINUE;
-    }
-
-    // Get transport info
-    if (process->transport) {
-        if (process->transport->flags & CLAP_TRANSPORT_HAS_SECONDS_TIMELINE) {
-            state->playheadPosition = static_cast<double>(process->transport->song_pos_seconds) / CLAP_SECTIME_FACTOR;
-        }
-    }
-
-    // Check for valid audio buffers
-    if (!process->audio_inputs || !process->audio_outputs ||
-        process->audio_inputs_count == 0 || process->audio_outputs_count == 0) {
-        return CLAP_PROCESS_CONTINUE;
-    }
-
-    const float* inL = process->audio_inputs[0].data32 ? process->audio_inputs[0].data32[0] : nullptr;
-    const float* inR = process->audio_inputs[0].data32 ? process->audio_inputs[0].data32[1] : nullptr;
-    float* outL = process->audio_outputs[0].data32 ? process->audio_outputs[0].data32[0] : nullptr;
-    float* outR = process->audio_outputs[0].data32 ? process->audio_outputs[0].data32[1] : nullptr;
-
-    if (!inL || !outL) {
-        return CLAP_PROCESS_CONTINUE;
-    }
-
-    // Pass through audio
-    if (inL != outL) memcpy(outL, inL, frameCount * sizeof(float));
-    if (inR && outR && inR != outR) memcpy(outR, inR, frameCount * sizeof(float));
-
-    // Ensure mono buffer is large enough
-    state->ensureMonoBuffer(frameCount);
-
-    // Mix to mono
-    if (inR) {
-        for (uint32_t i = 0; i < frameCount; ++i) {
-            state->monoBuffer[i] = (inL[i] + inR[i]) * 0.5f;
-        }
-    } else {
-        memcpy(state->monoBuffer.data(), inL, frameCount * sizeof(float));
-    }
-
-    // Feed samples to analyzer
-    uint32_t offset = 0;
-    while (offset < frameCount) {
-        uint32_t samplesNeeded = state->analyzer.getSamplesNeeded();
-        uint32_t remaining = frameCount - offset;
-        uint32_t toAdd = std::min(remaining, samplesNeeded);
-
-        bool bufferFull = state->analyzer.addSamples(state->monoBuffer.data() + offset, toAdd);
-        offset += toAdd;
-
-        if (bufferFull) {
-            float rms = state->analyzer.computeRMS();
-
-            if (rms >= SILENCE_THRESHOLD_DB) {
-                state->analyzer.computeFFT();
-                state->currentF0 = state->analyzer.detectF0();
-                state->currentCentroid = state->analyzer.computeSpectralCentroid();
-                state->currentRms = rms;
-            } else {
-                state->currentF0 = 0.0f;
-                state->currentCentroid = 0.0f;
-                state->currentRms = rms;
-            }
-
-            state->analyzer.resetBuffer();
-
-            // Update the streamer with current metrics (streamer handles timing independently)
-            state->streamer.updateMetrics(
-                state->currentF0,
-                state->currentCentroid,
-                state->currentRms,
-                state->playheadPosition
-            );
-        }
-    }
-
-    return CLAP_PROCESS_CONTINUE;
-}
-
-static const void* plugin_get_extension(const clap_plugin_t* /*plugin*/, const char* id) {
-    if (strcmp(id, CLAP_EXT_AUDIO_PORTS) == 0) {
-        return &audioPortsExtension;
-    }
-    if (strcmp(id, CLAP_EXT_TAIL) == 0) {
-        return &tailExtension;
-    }
-    return nullptr;
-}
-
-static void plugin_on_main_thread(const clap_plugin_t* /*plugin*/) {
-}
-
-static const clap_plugin_t* create_plugin(const clap_plugin_factory_t* /*factory*/,
-                                          const clap_host_t* /*host*/,
-                                          const char* pluginId) {
-    if (strcmp(pluginId, pluginDescriptor.id) != 0) {
-        return nullptr;
-    }
-
-    auto* plugin = new clap_plugin_t{
-        .desc = &pluginDescriptor,
-        .plugin_data = nullptr,
-        .init = plugin_init,
-        .destroy = plugin_destroy,
-        .activate = plugin_activate,
-        .deactivate = plugin_deactivate,
-        .start_processing = plugin_start_processing,
-        .stop_processing = plugin_stop_processing,
-        .reset = plugin_reset,
-        .process = plugin_process,
-        .get_extension = plugin_get_extension,
-        .on_main_thread = plugin_on_main_thread
-    };
-
-    return plugin;
-}
-
-static uint32_t factory_get_plugin_count(const clap_plugin_factory_t* /*factory*/) {
-    return 1;
-}
-
-static const clap_plugin_descriptor_t* factory_get_plugin_descriptor(const clap_plugin_factory_t* /*factory*/, uint32_t index) {
-    return index == 0 ? &pluginDescriptor : nullptr;
-}
-
-static const clap_plugin_t* factory_create_plugin(const clap_plugin_factory_t* factory,
-                                                   const clap_host_t* host,
-                                                   const char* pluginId) {
-    return create_plugin(factory, host, pluginId);
-}
-
-static const clap_plugin_factory_t pluginFactory = {
-    .get_plugin_count = factory_get_plugin_count,
-    .get_plugin_descriptor = factory_get_plugin_descriptor,
-    .create_plugin = factory_create_plugin
-};
-
-static bool entry_init(const char* /*pluginPath*/) {
-    return true;
-}
-
-static void entry_deinit(void) {
-}
-
-static const void* entry_get_factory(const char* factoryId) {
-    if (strcmp(factoryId, CLAP_PLUGIN_FACTORY_ID) == 0) {
-        return &pluginFactory;
-    }
-    return nullptr;
-}
-
-extern "C" CLAP_EXPORT const clap_plugin_entry_t clap_entry = {
-    .clap_version = CLAP_VERSION,
-    .init = entry_init,
-    .deinit = entry_deinit,
-    .get_factory = entry_get_factory
-};
+// AudioTracker CLAP Plugin
+// Real-time audio analysis with FFT, pitch detection, and metrics posting
+
+#include <clap/clap.h>
+#include <curl/curl.h>
+
+#include "fft_backend.h"
+#include "json_writer.h"
+#include "sample_fifo.h"
+#include "spectrum_kernel.h"
+#include "spsc_ring.h"
+#include "transport.h"
+#include "wire_format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <string>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <atomic>
+#include <queue>
+#include <chrono>
+#include <cstdlib>
+#include <random>
+
+// Plugin constants
+static constexpr uint32_t DEFAULT_FRAME_SIZE = 4096;  // 1024, 2048, 4096 or 8192, see createAnalyzer()
+static constexpr uint32_t DEFAULT_HOP_SIZE = 512;  // ~11.6 ms at 44.1 kHz, 87.5% overlap
+static constexpr uint32_t TRANSIENT_FRAME_SIZE = 512;  // multi-resolution short frames
+static constexpr uint32_t TRANSIENT_HOP_SIZE = 128;    // ~2.9 ms at 44.1 kHz
+static constexpr uint32_t MULTI_RESOLUTION_HOP_SIZE = 1024;  // long frames in multi-resolution mode
+static constexpr float ONSET_MIN_FLUX = 0.2f;      // fraction of the frame's magnitude that is new
+static constexpr float ONSET_DEVIATIONS = 3.0f;    // above the recent mean, in mean absolute deviations
+static constexpr float ONSET_MEAN_WEIGHT = 0.1f;   // per-frame weight of the flux statistics
+static constexpr uint32_t ONSET_MIN_INTERVAL_FRAMES = 16;  // ~46 ms at 44.1 kHz
+static constexpr float DEFAULT_SILENCE_THRESHOLD_DB = -50.0f;
+static constexpr float DEFAULT_MIN_F0_HZ = 60.0f;
+static constexpr float DEFAULT_MAX_F0_HZ = 600.0f;
+static constexpr uint32_t F0_HARMONICS = 4;  // partials summed per F0 candidate
+static constexpr uint32_t MIN_F0_BINS = 3;   // lowest F0 candidate, see updateF0Bins()
+static constexpr const char* API_URL = "http://localhost:9091/api/audio";
+static constexpr uint32_t METRIC_QUEUE_SIZE = 1024;  // ~10 s of frames at the default hop
+static constexpr uint32_t DEFAULT_STREAM_INTERVAL_MS = 100;
+static constexpr uint32_t MAX_BATCH_SIZE = 64;  // frames per POST or datagram
+static constexpr size_t JSON_BUFFER_SIZE = 32 * 1024;
+static constexpr size_t MAX_RECORD_JSON_SIZE = 352;  // generous bound for one serialized MetricRecord
+static constexpr uint32_t ANALYSIS_FIFO_SIZE = 1u << 16;  // samples, ~1.5 s at 44.1 kHz
+static constexpr uint32_t ANALYSIS_BLOCK_QUEUE_SIZE = 512;
+static constexpr uint32_t WORKER_IDLE_SLEEP_US = 1000;
+static constexpr uint32_t DEFAULT_MAX_BLOCK_SIZE = 4096;  // until activate() reports the host's
+static constexpr uint32_t MAX_ANALYSIS_JOBS = 8;  // analysis tasks run concurrently on the host pool
+static constexpr uint32_t MAX_CHANNELS = 8;       // 7.1
+static constexpr uint32_t DEFAULT_CHANNEL_COUNT = 2;
+
+// ============================================================================
+// Audio Analyzer - all buffers pre-allocated, FFT backend chosen in fft_backend.h
+// ============================================================================
+//
+// Input is kept in a circular buffer indexed by absolute sample position. Once
+// frameSize samples have arrived, a new frame is ready every hopSize_ samples
+// and covers the frameSize samples before its end position, so consecutive
+// frames overlap by frameSize - hopSize_. The ring holds frameSize plus one
+// block, so every frame completed by a block can still be read after the
+// whole block has been appended - and analyzed independently of the others.
+//
+// The analyzer runs on 1..MAX_CHANNELS channels: a single ring per channel,
+// and each channel of a frame windowed and transformed on its own. (One FFT
+// call batching all channels measured slower than a call per channel with the
+// portable backend.)
+//
+// AudioAnalyzer owns the ring and the frame schedule; the per-frame DSP lives
+// in SizedAudioAnalyzer<FrameSize>, instantiated once per supported frame size
+// so every bound in the hot path is a compile-time constant. createAnalyzer()
+// picks the instantiation at activation.
+//
+// Multi-resolution mode adds a second schedule on the same ring: short
+// TRANSIENT_FRAME_SIZE frames every TRANSIENT_HOP_SIZE samples for RMS, flux
+// and onsets, which become the records, while the long frames move to
+// MULTI_RESOLUTION_HOP_SIZE and only supply F0 and centroid.
+
+struct ChannelMetrics {
+    float f0 = 0.0f;
+    float centroid = 0.0f;
+    float rms = -100.0f;
+    float flux = 0.0f;   // multi-resolution only, see TransientAnalyzer
+    float onset = 0.0f;  // 1 on the frame an onset is detected, else 0
+};
+
+struct FrameResult {
+    uint64_t samplePosition = 0;  // stream position one past the frame's last sample
+    ChannelMetrics channels[MAX_CHANNELS];
+};
+
+// ============================================================================
+// Transient Analyzer - the short frames of multi-resolution mode
+// ============================================================================
+//
+// Reads TRANSIENT_FRAME_SIZE-sample frames from the AudioAnalyzer ring and
+// fills in RMS, spectral flux and the onset flag of every channel. Flux
+// compares a frame with the one before, so a channel's frames run in stream
+// order; channels keep separate state and can run concurrently.
+
+class TransientAnalyzer {
+public:
+    static constexpr uint32_t kFrameSize = TRANSIENT_FRAME_SIZE;
+    static constexpr uint32_t kHalfSize = kFrameSize / 2;
+
+    // One channel's transform at a time
+    struct Scratch {
+        Scratch() : fft(kFrameSize) {}
+
+        RealFFT fft;
+        alignas(64) float windowed[kFrameSize];
+        alignas(64) float real[kHalfSize];
+        alignas(64) float imag[kHalfSize];
+    };
+
+    explicit TransientAnalyzer(uint32_t channels) : previous_(kHalfSize * channels) {
+        dsp::hannWindow(window_, kFrameSize);
+        reset();
+    }
+
+    // Forgets the previous spectra, so the next audible frame is an onset
+    void reset() {
+        std::fill(previous_.begin(), previous_.end(), 0.0f);
+        for (uint32_t c = 0; c < MAX_CHANNELS; ++c) {
+            hasPrevious_[c] = true;
+            fluxMean_[c] = 0.0f;
+            fluxDeviation_[c] = 0.0f;
+            framesSinceOnset_[c] = ONSET_MIN_INTERVAL_FRAMES;
+        }
+    }
+
+    // Carries previous's spectra and onset statistics over an analyzer swap,
+    // or without a previous only takes the next frame as the reference, so a
+    // swap reports no onset of its own. Same channel count; never allocates.
+    void continueFrom(const TransientAnalyzer* previous) {
+        if (!previous) {
+            reset();
+            std::fill(std::begin(hasPrevious_), std::end(hasPrevious_), false);
+            return;
+        }
+        std::copy(previous->previous_.begin(), previous->previous_.end(), previous_.begin());
+        std::copy(std::begin(previous->fluxMean_), std::end(previous->fluxMean_), std::begin(fluxMean_));
+        std::copy(std::begin(previous->fluxDeviation_), std::end(previous->fluxDeviation_), std::begin(fluxDeviation_));
+        std::copy(std::begin(previous->framesSinceOnset_), std::end(previous->framesSinceOnset_), std::begin(framesSinceOnset_));
+        std::copy(std::begin(previous->hasPrevious_), std::end(previous->hasPrevious_), std::begin(hasPrevious_));
+    }
+
+    // One channel of the frame starting at index start of that channel's ring
+    void analyzeFrame(uint32_t channel, const float* ring, uint32_t ringSize, uint32_t start,
+                      float silenceThresholdDb, Scratch& scratch, ChannelMetrics& metrics) {
+        const uint32_t first = std::min(kFrameSize, ringSize - start);
+        const float sumSquares = dsp::sumOfSquares(ring + start, first) + dsp::sumOfSquares(ring, kFrameSize - first);
+        metrics.rms = 20.0f * log10f(fmaxf(sqrtf(sumSquares * (1.0f / kFrameSize)), 1e-10f));
+
+        if (metrics.rms >= silenceThresholdDb) {
+            dsp::multiply(ring + start, window_, scratch.windowed, first);
+            dsp::multiply(ring, window_ + first, scratch.windowed + first, kFrameSize - first);
+            scratch.fft.forward(scratch.windowed, scratch.real, scratch.imag);
+            const float flux = computeFlux(channel, scratch);
+            metrics.flux = hasPrevious_[channel] ? flux : 0.0f;
+        } else {
+            std::fill_n(previous_.data() + static_cast<size_t>(channel) * kHalfSize, kHalfSize, 0.0f);
+            metrics.flux = 0.0f;
+        }
+        metrics.onset = detectOnset(channel, metrics.flux) ? 1.0f : 0.0f;
+        hasPrevious_[channel] = true;
+    }
+
+private:
+    // Half-wave rectified magnitude increase since the previous frame as a
+    // fraction of this frame's total magnitude: near 0 for a steady sound, 1
+    // for one that starts out of silence. Bin 0 (DC/Nyquist) is left out.
+    float computeFlux(uint32_t channel, const Scratch& scratch) {
+        const float* real = scratch.real;
+        const float* imag = scratch.imag;
+        float* previous = previous_.data() + static_cast<size_t>(channel) * kHalfSize;
+
+        float rise = 0.0f;
+        float total = 0.0f;
+        for (uint32_t i = 1; i < kHalfSize; ++i) {
+            const float magnitude = sqrtf(real[i] * real[i] + imag[i] * imag[i]);
+            rise += fmaxf(magnitude - previous[i], 0.0f);
+            total += magnitude;
+            previous[i] = magnitude;
+        }
+        return total > 0.0f ? rise / total : 0.0f;
+    }
+
+    // An onset is a flux of at least ONSET_MIN_FLUX that also stands
+    // ONSET_DEVIATIONS mean absolute deviations above the channel's recent
+    // mean, at most one every ONSET_MIN_INTERVAL_FRAMES. The deviation term
+    // ignores flux that rises and falls every few frames, such as low partials
+    // beating within one short window.
+    bool detectOnset(uint32_t channel, float flux) {
+        const float threshold = fluxMean_[channel] + ONSET_DEVIATIONS * fluxDeviation_[channel];
+        const bool onset = flux >= ONSET_MIN_FLUX && flux > threshold &&
+                           framesSinceOnset_[channel] >= ONSET_MIN_INTERVAL_FRAMES;
+        fluxDeviation_[channel] += ONSET_MEAN_WEIGHT * (fabsf(flux - fluxMean_[channel]) - fluxDeviation_[channel]);
+        fluxMean_[channel] += ONSET_MEAN_WEIGHT * (flux - fluxMean_[channel]);
+        framesSinceOnset_[channel] = onset ? 0 : std::min(framesSinceOnset_[channel] + 1, ONSET_MIN_INTERVAL_FRAMES);
+        return onset;
+    }
+
+    std::vector<float> previous_;      // last audible frame's magnitudes per channel, zero after silence
+    bool hasPrevious_[MAX_CHANNELS];  // false until the channel's first frame after continueFrom(nullptr)
+    float fluxMean_[MAX_CHANNELS];
+    float fluxDeviation_[MAX_CHANNELS];
+    uint32_t framesSinceOnset_[MAX_CHANNELS];
+    alignas(64) float window_[kFrameSize];
+};
+
+// Per-job working memory; one per concurrently running analysis task,
+// created by the analyzer that uses it
+struct FrameScratch {
+    virtual ~FrameScratch() = default;
+
+    std::unique_ptr<TransientAnalyzer::Scratch> transient;  // multi-resolution only
+};
+
+class AudioAnalyzer {
+public:
+    virtual ~AudioAnalyzer() = default;
+
+    uint32_t getFrameSize() const { return frameSize_; }
+
+    void setSampleRate(float sr) {
+        sampleRate_ = sr;
+        updateF0Bins();
+    }
+    float getSampleRate() const { return sampleRate_; }
+
+    // F0 search range in Hz. Never allocates, so it can change between blocks.
+    void setF0Range(float minHz, float maxHz) {
+        minF0Hz_ = minHz;
+        maxF0Hz_ = maxHz;
+        updateF0Bins();
+    }
+
+    // Frames whose RMS is below this get no FFT and report F0 and centroid as 0
+    void setSilenceThreshold(float db) { silenceThresholdDb_ = db; }
+    float getSilenceThreshold() const { return silenceThresholdDb_; }
+
+    // Power skips the per-bin square root: F0 is unaffected (same peak bin)
+    // and the centroid becomes power-weighted instead of magnitude-weighted
+    void setSpectrumValue(dsp::SpectrumValue value) { spectrumValue_ = value; }
+    dsp::SpectrumValue getSpectrumValue() const { return spectrumValue_; }
+
+    // Main thread only. Sizes the rings and the per-block frame lists, sets the
+    // hop for the mode and resets the buffer. Multi-resolution rings also keep
+    // one extra frame of history for long frames that wait, see scheduleFrames().
+    void configure(uint32_t channels, uint32_t maxBlockSize, bool multiResolution = false) {
+        channelCount_ = std::clamp(channels, 1u, MAX_CHANNELS);
+        maxBlockSize_ = std::max(maxBlockSize, 1u);
+        deferralLimit_ = multiResolution ? frameSize_ : 0;
+        hopSize_ = std::min(multiResolution ? MULTI_RESOLUTION_HOP_SIZE : DEFAULT_HOP_SIZE, frameSize_);
+
+        ringSize_ = 1;
+        while (ringSize_ < frameSize_ + deferralLimit_ + maxBlockSize_) ringSize_ <<= 1;
+        ring_.assign(static_cast<size_t>(ringSize_) * channelCount_, 0.0f);
+        ringMask_ = ringSize_ - 1;
+        frames_.resize(maxBlockSize_ + deferralLimit_ + 1);
+        dueFrames_.resize(frames_.size());
+
+        transient_.reset(multiResolution ? new TransientAnalyzer(channelCount_) : nullptr);
+        records_.resize(multiResolution ? maxBlockSize_ / TRANSIENT_HOP_SIZE + 1 : 0);
+        resetBuffer();
+    }
+    uint32_t getChannelCount() const { return channelCount_; }
+    uint32_t getMaxBlockSize() const { return maxBlockSize_; }
+    bool isMultiResolution() const { return transient_ != nullptr; }
+
+    // Hop between frames, clamped to [1, frame size]. Takes effect from the next hop.
+    void setHopSize(uint32_t hop) { hopSize_ = std::clamp(hop, 1u, frameSize_); }
+    uint32_t getHopSize() const { return hopSize_; }
+
+    // Appends at most getMaxBlockSize() samples of every channel (channels[c]
+    // for c < getChannelCount()) and returns how many frames are now due;
+    // those frames are then analyzed by the tasks from getTaskCount()
+    uint32_t addSamples(const float* const* channels, uint32_t offset, uint32_t count) {
+        count = std::min(count, maxBlockSize_);
+
+        const uint32_t start = static_cast<uint32_t>(samplePosition_) & ringMask_;
+        const uint32_t first = std::min(count, ringSize_ - start);
+        for (uint32_t c = 0; c < channelCount_; ++c) {
+            float* ring = channelRing(c);
+            const float* samples = channels[c] + offset;
+            memcpy(ring + start, samples, first * sizeof(float));
+            memcpy(ring, samples + first, (count - first) * sizeof(float));
+        }
+
+        advanceClock(samplesToFrame_, hopSize_, count, [this](uint64_t position) {
+            dueFrames_[(dueHead_ + dueCount_++) % dueFrames_.size()] = position;
+        });
+        recordCount_ = 0;
+        if (transient_) {
+            advanceClock(transientSamplesToFrame_, TRANSIENT_HOP_SIZE, count, [this](uint64_t position) {
+                records_[recordCount_++].samplePosition = position;
+            });
+        }
+        samplePosition_ += count;
+
+        scheduleFrames(count);
+        return frameCount_;
+    }
+
+    uint32_t getFrameCount() const { return frameCount_; }
+    const FrameResult& getFrame(uint32_t frame) const { return frames_[frame]; }
+
+    // Call after every task from the last addSamples() has run. Gives each
+    // short frame the F0 and centroid of the newest long frame ending at or
+    // before it; in single resolution only keeps the newest frame's, for
+    // continueFrom().
+    void completeRecords() {
+        if (!transient_) {
+            if (frameCount_ > 0) holdPitch(frames_[frameCount_ - 1]);
+            return;
+        }
+
+        uint32_t next = 0;
+        for (uint32_t r = 0; r < recordCount_; ++r) {
+            FrameResult& record = records_[r];
+            while (next < frameCount_ && frames_[next].samplePosition <= record.samplePosition) {
+                holdPitch(frames_[next++]);
+            }
+            for (uint32_t c = 0; c < channelCount_; ++c) {
+                record.channels[c].f0 = heldPitch_[c].f0;
+                record.channels[c].centroid = heldPitch_[c].centroid;
+            }
+        }
+        while (next < frameCount_) {
+            holdPitch(frames_[next++]);
+        }
+    }
+
+    // What to publish once the frames are analyzed: the analyzed frames, or
+    // in multi-resolution mode the short frames
+    uint32_t getRecordCount() const { return transient_ ? recordCount_ : frameCount_; }
+    const FrameResult& getRecord(uint32_t record) const { return transient_ ? records_[record] : frames_[record]; }
+
+    void resetBuffer() {
+        samplesToFrame_ = frameSize_;  // the first frame waits for a full window
+        transientSamplesToFrame_ = TRANSIENT_FRAME_SIZE;
+        samplePosition_ = 0;
+        frameCount_ = 0;
+        recordCount_ = 0;
+        dueHead_ = 0;
+        dueCount_ = 0;
+        frameCredit_ = 0.0;
+        std::fill(std::begin(heldPitch_), std::end(heldPitch_), ChannelMetrics());
+        if (transient_) transient_->reset();
+    }
+
+    // Restarts framing count samples further on, for input that was lost
+    // rather than analyzed: no frame spans the gap, the next one waits for a
+    // full window of new input, and stream positions stay on the host's
+    // timeline. Returns roughly how many records the lost input would have
+    // produced per channel.
+    uint32_t skipSamples(uint32_t count) {
+        const uint32_t recordHop = transient_ ? TRANSIENT_HOP_SIZE : hopSize_;
+        const uint64_t position = samplePosition_ + count;
+        resetBuffer();
+        samplePosition_ = position;
+        return count / recordHop;
+    }
+
+    // Samples consumed since the last reset, i.e. the stream position of the newest sample
+    uint64_t getSamplePosition() const { return samplePosition_; }
+
+    // Takes over previous's stream in place of a reset: the stream position,
+    // the hop phase, and as much of the newest input as both rings hold, so
+    // frames carry on without a gap when previous had a full frame of history.
+    // Short frames keep their flux reference and the last F0 and centroid;
+    // long frames still waiting in previous are dropped. Requires the same
+    // channel count and block size on both; copies but never allocates.
+    void continueFrom(const AudioAnalyzer& previous) {
+        samplePosition_ = previous.samplePosition_;
+        frameCount_ = 0;
+        recordCount_ = 0;
+
+        const uint64_t history = std::min<uint64_t>({ samplePosition_, previous.ringSize_, frameSize_ });
+        uint64_t position = samplePosition_ - history;
+        while (position < samplePosition_) {
+            const uint32_t from = static_cast<uint32_t>(position) & previous.ringMask_;
+            const uint32_t to = static_cast<uint32_t>(position) & ringMask_;
+            const uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(
+                { samplePosition_ - position, previous.ringSize_ - from, ringSize_ - to }));
+            for (uint32_t c = 0; c < channelCount_; ++c) {
+                memcpy(channelRing(c) + to, previous.channelRing(c) + from, count * sizeof(float));
+            }
+            position += count;
+        }
+
+        // Without a full frame of history the next frame waits for the rest
+        samplesToFrame_ = history < frameSize_ ? frameSize_ - static_cast<uint32_t>(history)
+                                               : std::min(previous.samplesToFrame_, hopSize_);
+        transientSamplesToFrame_ = history < TRANSIENT_FRAME_SIZE
+            ? TRANSIENT_FRAME_SIZE - static_cast<uint32_t>(history)
+            : std::min(previous.transientSamplesToFrame_, TRANSIENT_HOP_SIZE);
+        std::copy(std::begin(previous.heldPitch_), std::end(previous.heldPitch_), std::begin(heldPitch_));
+        if (transient_) transient_->continueFrom(previous.transient_.get());
+    }
+
+    // Main thread only. Working memory for one task at a time
+    virtual std::unique_ptr<FrameScratch> createScratch() const = 0;
+
+    // The work made due by the last addSamples(), as independent tasks: one
+    // per channel of every long frame, then in multi-resolution mode one per
+    // channel for all of its short frames. Tasks only read the ring and write
+    // their own part of the results, so any of them can run concurrently as
+    // long as each has its own scratch from createScratch().
+    uint32_t getTaskCount() const { return (frameCount_ + (recordCount_ > 0 ? 1 : 0)) * channelCount_; }
+
+    void runTask(uint32_t task, FrameScratch& scratch) {
+        const uint32_t frame = task / channelCount_;
+        const uint32_t channel = task % channelCount_;
+        if (frame < frameCount_) {
+            analyzeFrame(frame, channel, scratch);
+        } else {
+            analyzeTransients(channel, *scratch.transient);
+        }
+    }
+
+    // Analyzes one channel of a frame made due by the last addSamples();
+    // writes only frames_[frame].channels[channel]
+    virtual void analyzeFrame(uint32_t frame, uint32_t channel, FrameScratch& scratch) = 0;
+
+protected:
+    explicit AudioAnalyzer(uint32_t frameSize) : frameSize_(frameSize), samplesToFrame_(frameSize) {}
+
+    float* channelRing(uint32_t channel) { return ring_.data() + static_cast<size_t>(channel) * ringSize_; }
+    const float* channelRing(uint32_t channel) const { return ring_.data() + static_cast<size_t>(channel) * ringSize_; }
+
+    // Calls onFrame with the end position of every frame that count samples
+    // appended at samplePosition_ complete; samplesToFrame is how many the
+    // next frame still needs, and frames after it are hop apart
+    template <typename OnFrame>
+    void advanceClock(uint32_t& samplesToFrame, uint32_t hop, uint32_t count, OnFrame onFrame) const {
+        uint32_t remaining = count;
+        uint64_t position = samplePosition_;
+        while (remaining >= samplesToFrame) {
+            position += samplesToFrame;
+            remaining -= samplesToFrame;
+            onFrame(position);
+            samplesToFrame = hop;
+        }
+        samplesToFrame -= remaining;
+    }
+
+    // Moves due frames to frames_ for analyzeFrame(). Single resolution takes
+    // every one. Multi-resolution takes them at their average arrival rate, so
+    // a block that completes several (a large or irregular host block) leaves
+    // the surplus to the next blocks; a frame deferralLimit_ samples old is
+    // taken regardless, and the ring still holds it until the next block.
+    void scheduleFrames(uint32_t count) {
+        frameCount_ = 0;
+        frameCredit_ += static_cast<double>(count) / hopSize_;
+        while (dueCount_ > 0) {
+            const uint64_t position = dueFrames_[dueHead_];
+            const bool overdue = samplePosition_ - position >= deferralLimit_;
+            if (!overdue && frameCredit_ < 1.0) break;
+
+            frames_[frameCount_++].samplePosition = position;
+            dueHead_ = (dueHead_ + 1) % dueFrames_.size();
+            --dueCount_;
+            frameCredit_ -= 1.0;
+        }
+
+        // Idle time does not bank credit for a burst later
+        if (dueCount_ == 0) frameCredit_ = std::min(frameCredit_, 1.0);
+    }
+
+    // One channel's short frames from the last addSamples(), in stream order;
+    // writes only RMS, flux and onset of records_[r].channels[channel]
+    void analyzeTransients(uint32_t channel, TransientAnalyzer::Scratch& scratch) {
+        const float* ring = channelRing(channel);
+        for (uint32_t r = 0; r < recordCount_; ++r) {
+            const uint32_t start = static_cast<uint32_t>(records_[r].samplePosition - TRANSIENT_FRAME_SIZE) & ringMask_;
+            transient_->analyzeFrame(channel, ring, ringSize_, start, silenceThresholdDb_, scratch,
+                                     records_[r].channels[channel]);
+        }
+    }
+
+    void holdPitch(const FrameResult& frame) {
+        for (uint32_t c = 0; c < channelCount_; ++c) {
+            heldPitch_[c].f0 = frame.channels[c].f0;
+            heldPitch_[c].centroid = frame.channels[c].centroid;
+        }
+    }
+
+    // F0 search range in bins; every candidate keeps a neighbour on both sides
+    // for interpolation. Partials closer than about MIN_F0_BINS merge under the
+    // Hann window, so the range starts there whatever the Min F0 setting: about
+    // 130 Hz at 1024 samples and 65 Hz at 2048 (44.1 kHz).
+    void updateF0Bins() {
+        const uint32_t halfSize = frameSize_ / 2;
+        float freqBinWidth = sampleRate_ / frameSize_;
+        minF0Bin_ = std::clamp(static_cast<uint32_t>(minF0Hz_ / freqBinWidth), MIN_F0_BINS, halfSize - 2);
+        maxF0Bin_ = std::clamp(static_cast<uint32_t>(maxF0Hz_ / freqBinWidth), minF0Bin_, halfSize - 2);
+    }
+
+    // Offset in bins, within +-0.5, of the vertex of the parabola through the
+    // log spectrum at bin - 1, bin, bin + 1. Log makes it exact for a Gaussian
+    // peak and close for the Hann window; magnitude or power gives the same offset.
+    static float interpolatePeak(const float* spectrum, uint32_t bin) {
+        const float floor = 1e-20f;
+        const float a = logf(fmaxf(spectrum[bin - 1], floor));
+        const float b = logf(fmaxf(spectrum[bin], floor));
+        const float c = logf(fmaxf(spectrum[bin + 1], floor));
+        const float curvature = a - 2.0f * b + c;
+        if (curvature >= 0.0f) return 0.0f;
+        return std::clamp(0.5f * (a - c) / curvature, -0.5f, 0.5f);
+    }
+
+    const uint32_t frameSize_;
+
+    float sampleRate_ = 44100.0f;
+    dsp::SpectrumValue spectrumValue_ = dsp::SpectrumValue::Magnitude;
+    float silenceThresholdDb_ = DEFAULT_SILENCE_THRESHOLD_DB;
+    float minF0Hz_ = DEFAULT_MIN_F0_HZ;
+    float maxF0Hz_ = DEFAULT_MAX_F0_HZ;
+    uint32_t minF0Bin_ = 1;
+    uint32_t maxF0Bin_ = 1;
+
+    std::vector<float> ring_;  // channelCount_ rings of ringSize_ samples
+    uint32_t ringSize_ = 0;
+    uint32_t ringMask_ = 0;
+    uint32_t channelCount_ = 1;
+    uint32_t maxBlockSize_ = 0;
+
+    std::vector<uint64_t> dueFrames_;  // end positions of completed frames not yet analyzed
+    uint32_t dueHead_ = 0;
+    uint32_t dueCount_ = 0;
+    uint32_t deferralLimit_ = 0;  // samples a due frame may wait, 0 outside multi-resolution
+    double frameCredit_ = 0.0;    // frames scheduleFrames() may take without one being overdue
+
+    std::vector<FrameResult> frames_;  // frames due for analysis after the last addSamples()
+    uint32_t frameCount_ = 0;
+
+    uint32_t hopSize_ = DEFAULT_HOP_SIZE;
+    uint32_t samplesToFrame_;
+    uint64_t samplePosition_ = 0;
+
+    // Multi-resolution: short frames completed by the last addSamples(), and
+    // the newest long frame's F0 and centroid per channel
+    std::unique_ptr<TransientAnalyzer> transient_;
+    std::vector<FrameResult> records_;
+    uint32_t recordCount_ = 0;
+    uint32_t transientSamplesToFrame_ = TRANSIENT_FRAME_SIZE;
+    ChannelMetrics heldPitch_[MAX_CHANNELS];
+};
+
+// The DSP for one frame size. The window is a fixed, 64-byte aligned member
+// and every frame-length and bin-count bound below is a constant, so the
+// windowing, summation and F0 loops compile to fixed trip counts.
+template <uint32_t FrameSize>
+class SizedAudioAnalyzer final : public AudioAnalyzer {
+    static_assert(FrameSize >= 16 && (FrameSize & (FrameSize - 1)) == 0, "FrameSize must be a power of two");
+
+public:
+    static constexpr uint32_t kFrameSize = FrameSize;
+    static constexpr uint32_t kHalfSize = FrameSize / 2;
+
+    // One channel's transform at a time
+    struct Scratch final : FrameScratch {
+        Scratch() : fft(kFrameSize), windowed(kFrameSize), real(kHalfSize), imag(kHalfSize), spectrum(kHalfSize) {}
+
+        RealFFT fft;
+        std::vector<float> windowed;
+        std::vector<float> real;
+        std::vector<float> imag;
+        std::vector<float> spectrum;  // magnitudes or power, see AudioAnalyzer::setSpectrumValue()
+    };
+
+    SizedAudioAnalyzer() : AudioAnalyzer(kFrameSize) {
+        dsp::hannWindow(window_, kFrameSize);
+        configure(1, DEFAULT_MAX_BLOCK_SIZE);
+        setSampleRate(sampleRate_);
+    }
+
+    std::unique_ptr<FrameScratch> createScratch() const override {
+        std::unique_ptr<FrameScratch> scratch(new Scratch());
+        if (transient_) scratch->transient.reset(new TransientAnalyzer::Scratch());
+        return scratch;
+    }
+
+    void analyzeFrame(uint32_t frame, uint32_t channel, FrameScratch& frameScratch) override {
+        Scratch& scratch = static_cast<Scratch&>(frameScratch);
+        ChannelMetrics& metrics = frames_[frame].channels[channel];
+
+        // The frame is two contiguous ring segments, oldest sample first
+        const float* ring = channelRing(channel);
+        const uint32_t start = static_cast<uint32_t>(frames_[frame].samplePosition - kFrameSize) & ringMask_;
+        const uint32_t first = std::min(kFrameSize, ringSize_ - start);
+
+        metrics.rms = computeRMS(ring + start, first, ring, kFrameSize - first);
+        if (metrics.rms >= silenceThresholdDb_) {
+            computeFFT(ring, start, first, scratch);
+            const dsp::SpectrumSummary summary = computeSpectrum(scratch);
+            metrics.f0 = detectF0(summary, scratch.spectrum.data());
+            metrics.centroid = computeSpectralCentroid(summary);
+        } else {
+            metrics.f0 = 0.0f;
+            metrics.centroid = 0.0f;
+        }
+    }
+
+private:
+    static float computeRMS(const float* head, uint32_t headCount, const float* tail, uint32_t tailCount) {
+        float sumSquares = dsp::sumOfSquares(head, headCount) + dsp::sumOfSquares(tail, tailCount);
+        float rms = sqrtf(sumSquares * (1.0f / kFrameSize));
+        return 20.0f * log10f(fmaxf(rms, 1e-10f));
+    }
+
+    // Windows one channel's frame into scratch and transforms it
+    void computeFFT(const float* ring, uint32_t start, uint32_t headCount, Scratch& scratch) const {
+        float* windowed = scratch.windowed.data();
+        dsp::multiply(ring + start, window_, windowed, headCount);
+        dsp::multiply(ring, window_ + headCount, windowed + headCount, kFrameSize - headCount);
+
+        scratch.fft.forward(windowed, scratch.real.data(), scratch.imag.data());
+    }
+
+    // Magnitude or power spectrum of the transform plus the sums and peak the
+    // features need, all from a single pass over its bins
+    dsp::SpectrumSummary computeSpectrum(Scratch& scratch) const {
+        const float* real = scratch.real.data();
+        const float* imag = scratch.imag.data();
+        float* spectrum = scratch.spectrum.data();
+        constexpr float scale = 1.0f / (kFrameSize * 2);
+
+        if (spectrumValue_ == dsp::SpectrumValue::Power) {
+            return dsp::summarizeSpectrum<dsp::SpectrumValue::Power>(
+                real, imag, spectrum, kHalfSize, scale, minF0Bin_, maxF0Bin_);
+        }
+        return dsp::summarizeSpectrum<dsp::SpectrumValue::Magnitude>(
+            real, imag, spectrum, kHalfSize, scale, minF0Bin_, maxF0Bin_);
+    }
+
+    float computeSpectralCentroid(const dsp::SpectrumSummary& summary) const {
+        // sum(freq * mag) / sum(mag), with freq = bin * binWidth factored out
+        float freqBinWidth = sampleRate_ / kFrameSize;
+        return summary.sum > 0.0f ? freqBinWidth * summary.weightedSum / summary.sum : 0.0f;
+    }
+
+    // Harmonic sum: each candidate bin k in the F0 range scores
+    // sum(w[h] * spectrum[~h * k]) over the first F0_HARMONICS partials, which
+    // keeps a strong 2nd harmonic from winning. Partial h of a fundamental
+    // anywhere in bin k lies within h/2 bins of h * k, so the largest value
+    // there is taken - but never more than (k - 1)/2 bins away, or at low k a
+    // candidate's windows would reach the partials of a higher fundamental.
+    // Only local spectral peaks are candidates, so a bin on the slope below a
+    // fundamental cannot collect its partials either. The weights decay
+    // slowly so a subharmonic (which collects the same partials one slot
+    // later) never ties the fundamental. The winner is placed between bins by
+    // a parabola through the log spectrum.
+    float detectF0(const dsp::SpectrumSummary& summary, const float* spectrum) const {
+        float freqBinWidth = sampleRate_ / kFrameSize;
+        float threshold = spectrumValue_ == dsp::SpectrumValue::Power ? 0.001f * 0.001f : 0.001f;
+        if (summary.peak < threshold) return 0.0f;
+
+        static constexpr float harmonicWeights[F0_HARMONICS] = { 1.0f, 0.9f, 0.81f, 0.729f };
+
+        float bestScore = 0.0f;
+        uint32_t bin = summary.peakIndex;  // no local peak in range: the range maximum
+        for (uint32_t k = minF0Bin_; k <= maxF0Bin_; ++k) {
+            if (spectrum[k] < spectrum[k - 1] || spectrum[k] < spectrum[k + 1]) continue;
+
+            float score = 0.0f;
+            for (uint32_t h = 1; h <= F0_HARMONICS; ++h) {
+                const uint32_t reach = std::min(h / 2, (k - 1) / 2);
+                const uint32_t last = std::min(h * k + reach, kHalfSize - 1);
+                float partial = 0.0f;
+                for (uint32_t i = h * k - reach; i <= last; ++i) {
+                    partial = fmaxf(partial, spectrum[i]);
+                }
+                score += partial * harmonicWeights[h - 1];
+            }
+            if (score > bestScore) {
+                bestScore = score;
+                bin = k;
+            }
+        }
+
+        return (bin + interpolatePeak(spectrum, bin)) * freqBinWidth;
+    }
+
+    alignas(64) float window_[kFrameSize];
+};
+
+// Runtime dispatch to the compiled frame sizes; any other size gets DEFAULT_FRAME_SIZE
+static std::unique_ptr<AudioAnalyzer> createAnalyzer(uint32_t frameSize) {
+    switch (frameSize) {
+        case 1024: return std::unique_ptr<AudioAnalyzer>(new SizedAudioAnalyzer<1024>());
+        case 2048: return std::unique_ptr<AudioAnalyzer>(new SizedAudioAnalyzer<2048>());
+        case 8192: return std::unique_ptr<AudioAnalyzer>(new SizedAudioAnalyzer<8192>());
+        default:   return std::unique_ptr<AudioAnalyzer>(new SizedAudioAnalyzer<DEFAULT_FRAME_SIZE>());
+    }
+}
+
+// ============================================================================
+// Metric records - one per analysis frame, passed by value through the queue
+// ============================================================================
+
+struct MetricRecord {
+    uint64_t sequence = 0;  // per-instance record counter, gaps mean dropped records
+    uint64_t samplePosition = 0;  // stream position of the frame's last sample
+    uint32_t channel = 0;  // input channel, 0 for the downmix
+    float f0 = 0.0f;
+    float centroid = 0.0f;
+    float rms = -100.0f;
+    float flux = 0.0f;
+    float onset = 0.0f;
+    double playhead = 0.0;
+};
+
+using MetricQueue = SpscRing<MetricRecord, METRIC_QUEUE_SIZE>;
+
+// AUDIOTRACKER_WIRE_FORMAT=binary starts new instances on the binary format
+static WireFormat wireFormatFromEnvironment() {
+    const char* value = getenv("AUDIOTRACKER_WIRE_FORMAT");
+    if (value && strcmp(value, "binary") == 0) {
+        return WireFormat::Binary;
+    }
+    return WireFormat::Json;
+}
+
+// Random per-process base plus a counter, so ids stay unique across plugin
+// instances and across concurrently running hosts
+static uint32_t makeInstanceId() {
+    static const uint32_t base = std::random_device{}();
+    static std::atomic<uint32_t> counter{0};
+    return base + counter.fetch_add(1, std::memory_order_relaxed) * 0x9E3779B9u;
+}
+
+// ============================================================================
+// Metrics channel - one per plugin instance, written by its audio thread
+// ============================================================================
+
+class MetricsChannel {
+public:
+    MetricsChannel() : instanceId_(makeInstanceId()) {}
+
+    // Called from audio thread for every analysis frame. Wait-free: never blocks
+    // or allocates, and if the hub has fallen behind the frame is counted as an
+    // overflow instead.
+    void updateMetrics(uint32_t channel, const ChannelMetrics& metrics, double playhead, uint64_t samplePosition) {
+        MetricRecord record;
+        record.sequence = nextSequence_++;
+        record.samplePosition = samplePosition;
+        record.channel = channel;
+        record.f0 = metrics.f0;
+        record.centroid = metrics.centroid;
+        record.rms = metrics.rms;
+        record.flux = metrics.flux;
+        record.onset = metrics.onset;
+        record.playhead = playhead;
+
+        if (!queue_.push(record)) {
+            overflowCount_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Records that never reached the queue, e.g. for a block the analysis
+    // worker could not take; reported with the overflows
+    void addDropped(uint64_t records) {
+        overflowCount_.fetch_add(records, std::memory_order_relaxed);
+    }
+
+    uint64_t getOverflowCount() const {
+        return overflowCount_.load(std::memory_order_relaxed);
+    }
+
+    uint32_t getInstanceId() const { return instanceId_; }
+
+    // Any thread. How often this instance wants its records sent; the hub
+    // ticks at the shortest interval of all open channels.
+    void setStreamInterval(uint32_t ms) { streamIntervalMs_.store(ms, std::memory_order_relaxed); }
+    uint32_t getStreamInterval() const { return streamIntervalMs_.load(std::memory_order_relaxed); }
+
+    // Any thread. The format this instance's records are sent in; the hub
+    // batches each format separately.
+    void setWireFormat(WireFormat format) { wireFormat_.store(format, std::memory_order_relaxed); }
+    WireFormat getWireFormat() const { return wireFormat_.load(std::memory_order_relaxed); }
+
+    // Hub thread only
+    bool pop(MetricRecord& record) { return queue_.pop(record); }
+
+    // Set by the owning instance on destroy; the hub drains what is left, then
+    // drops the channel
+    void close() { closed_.store(true, std::memory_order_release); }
+    bool isClosed() const { return closed_.load(std::memory_order_acquire); }
+
+private:
+    const uint32_t instanceId_;
+
+    // Audio thread (producer) side
+    MetricQueue queue_;
+    uint64_t nextSequence_ = 0;
+    std::atomic<uint64_t> overflowCount_{0};
+
+    std::atomic<bool> closed_{false};
+    std::atomic<uint32_t> streamIntervalMs_{DEFAULT_STREAM_INTERVAL_MS};
+    std::atomic<WireFormat> wireFormat_{WireFormat::Json};
+};
+
+// ============================================================================
+// Streaming hub - one timer thread and one connection for every instance in
+// the process. Created by the first plugin_init, destroyed by the last
+// plugin_destroy; batches mix records from all open channels that use the
+// same wire format, each tagged with its instance id.
+// ============================================================================
+
+class StreamingHub {
+public:
+    // Main thread: returns the shared hub, creating it on first use
+    static StreamingHub& acquire() {
+        std::lock_guard<std::mutex> lock(instanceMutex());
+        if (refCount()++ == 0) {
+            instance() = new StreamingHub();
+        }
+        return *instance();
+    }
+
+    // Main thread: the last release flushes every channel and stops the thread
+    static void release() {
+        std::lock_guard<std::mutex> lock(instanceMutex());
+        if (refCount() > 0 && --refCount() == 0) {
+            delete instance();
+            instance() = nullptr;
+        }
+    }
+
+    std::shared_ptr<MetricsChannel> openChannel() {
+        auto channel = std::make_shared<MetricsChannel>();
+        std::lock_guard<std::mutex> lock(channelsMutex_);
+        channels_.push_back(channel);
+        return channel;
+    }
+
+private:
+    StreamingHub() : running_(true) {
+        curl_global_init(CURL_GLOBAL_DEFAULT);
+        for (auto& pending : pending_) {
+            pending.reserve(METRIC_QUEUE_SIZE);
+        }
+        hubThread_ = std::thread(&StreamingHub::hubLoop, this);
+    }
+
+    ~StreamingHub() {
+        running_ = false;
+        if (hubThread_.joinable()) {
+            hubThread_.join();
+        }
+        curl_global_cleanup();
+    }
+
+    static std::mutex& instanceMutex() { static std::mutex m; return m; }
+    static StreamingHub*& instance() { static StreamingHub* hub = nullptr; return hub; }
+    static uint32_t& refCount() { static uint32_t count = 0; return count; }
+
+    void hubLoop() {
+        // Created on this thread; HTTP unless AUDIOTRACKER_TRANSPORT picks a socket
+        std::unique_ptr<MetricsTransport> transport = createTransport(
+            getenv("AUDIOTRACKER_TRANSPORT"), API_URL, static_cast<uint32_t>(getpid()));
+
+        while (running_) {
+            // Sleep for streaming interval
+            std::this_thread::sleep_for(std::chrono::milliseconds(streamIntervalMs_));
+
+            if (!running_) break;
+
+            transport->poll();
+            sendQueued(*transport);
+        }
+
+        // Flush whatever the audio threads produced since the last tick
+        transport->poll();
+        sendQueued(*transport);
+    }
+
+    // Records per JSON array or binary packet: MAX_BATCH_SIZE, or fewer
+    // if that would not fit the transport's payload limit. A larger backlog is
+    // sent as several consecutive batches within the same tick.
+    size_t batchCapacity(const MetricsTransport& transport, WireFormat format) const {
+        const size_t payload = std::min<size_t>(transport.maxPayloadSize(),
+            format == WireFormat::Binary ? SIZE_MAX : JSON_BUFFER_SIZE);
+        const size_t capacity = format == WireFormat::Binary
+            ? std::min<size_t>(packet_.maxRecords(), (payload - sizeof(wire::PacketHeader)) / wire::RECORD_SIZE)
+            : (payload - 2) / MAX_RECORD_JSON_SIZE;
+        return std::min<size_t>(MAX_BATCH_SIZE, std::max<size_t>(capacity, 1));
+    }
+
+    // Drains every open channel into one list per wire format, then sends each
+    // list as JSON arrays or binary packets
+    void sendQueued(MetricsTransport& transport) {
+        // Collect under the lock, send outside it so openChannel() never waits on I/O
+        for (auto& pending : pending_) {
+            pending.clear();
+        }
+        {
+            std::lock_guard<std::mutex> lock(channelsMutex_);
+            uint32_t interval = UINT32_MAX;
+            for (auto it = channels_.begin(); it != channels_.end();) {
+                MetricsChannel& channel = **it;
+                interval = std::min(interval, channel.getStreamInterval());
+
+                // Read before draining so frames pushed just before close() are still sent
+                const bool closed = channel.isClosed();
+
+                std::vector<QueuedMetric>& pending = pending_[static_cast<size_t>(channel.getWireFormat())];
+                MetricRecord record;
+                while (channel.pop(record)) {
+                    pending.push_back({ channel.getInstanceId(), channel.getOverflowCount(), record });
+                }
+                it = closed ? channels_.erase(it) : it + 1;
+            }
+            streamIntervalMs_ = interval == UINT32_MAX ? DEFAULT_STREAM_INTERVAL_MS : interval;
+        }
+
+        for (const WireFormat format : { WireFormat::Json, WireFormat::Binary }) {
+            const std::vector<QueuedMetric>& pending = pending_[static_cast<size_t>(format)];
+            const size_t maxRecords = batchCapacity(transport, format);
+            for (size_t first = 0; first < pending.size(); first += maxRecords) {
+                const size_t count = std::min<size_t>(maxRecords, pending.size() - first);
+                if (format == WireFormat::Binary) {
+                    encodeBatch(pending, first, count);
+                    transport.send(reinterpret_cast<const char*>(packet_.finish()), packet_.size(), format);
+                } else {
+                    serializeBatch(pending, first, count);
+                    transport.send(json_.data(), json_.size(), format);
+                }
+            }
+        }
+    }
+
+    static int64_t wallClockMillis() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    struct QueuedMetric {
+        uint32_t instanceId;
+        uint64_t dropped;  // channel overflow count when the record was collected
+        MetricRecord record;
+    };
+
+    void encodeBatch(const std::vector<QueuedMetric>& pending, size_t first, size_t count) {
+        packet_.begin(wallClockMillis());
+        for (size_t i = first; i < first + count; ++i) {
+            const MetricRecord& r = pending[i].record;
+            wire::RecordHeader header = {};
+            header.instanceId = pending[i].instanceId;
+            header.channel = r.channel;
+            header.sequence = r.sequence;
+            header.samplePosition = r.samplePosition;
+            header.playheadSeconds = r.playhead;
+
+            const float fields[wire::FIELD_COUNT] = { r.f0, r.centroid, r.rms, r.flux, r.onset };
+            packet_.add(header, fields);
+        }
+    }
+
+    void serializeBatch(const std::vector<QueuedMetric>& pending, size_t first, size_t count) {
+        const int64_t localTime = wallClockMillis();
+
+        json_.clear();
+        json_.raw('[');
+        for (size_t i = first; i < first + count; ++i) {
+            const QueuedMetric& m = pending[i];
+            const MetricRecord& r = m.record;
+            if (i > first) json_.raw(',');
+            json_.raw('{');
+            json_.key("instance");  json_.value(static_cast<uint64_t>(m.instanceId)); json_.raw(',');
+            json_.key("channel");   json_.value(static_cast<uint64_t>(r.channel)); json_.raw(',');
+            json_.key("seq");       json_.value(r.sequence);   json_.raw(',');
+            json_.key("samplePosition"); json_.value(r.samplePosition); json_.raw(',');
+            json_.key("dropped");   json_.value(m.dropped);    json_.raw(',');
+            json_.key("f0");        json_.value(r.f0);         json_.raw(',');
+            json_.key("centroid");  json_.value(r.centroid);   json_.raw(',');
+            json_.key("rms");       json_.value(r.rms);        json_.raw(',');
+            json_.key("flux");      json_.value(r.flux, 3);    json_.raw(',');
+            json_.key("onset");     json_.value(r.onset, 0);   json_.raw(',');
+            json_.key("startedAt"); json_.timestamp(r.playhead); json_.raw(',');
+            json_.key("endedAt");   json_.timestamp(r.playhead); json_.raw(',');
+            json_.key("localTime"); json_.value(localTime);
+            json_.raw('}');
+        }
+        json_.raw(']');
+    }
+
+    std::thread hubThread_;
+    std::atomic<bool> running_;
+
+    std::mutex channelsMutex_;  // main thread (open) vs hub thread (drain); never the audio thread
+    std::vector<std::shared_ptr<MetricsChannel>> channels_;
+
+    // Hub thread side
+    uint32_t streamIntervalMs_ = DEFAULT_STREAM_INTERVAL_MS;
+    std::vector<QueuedMetric> pending_[WIRE_FORMAT_COUNT];  // indexed by WireFormat
+    JsonWriter json_{JSON_BUFFER_SIZE};
+    wire::PacketWriter packet_{METRIC_QUEUE_SIZE};
+};
+
+// ============================================================================
+// Analysis worker - optional (AUDIOTRACKER_ANALYSIS=worker). The audio thread
+// only copies the analyzed channels into FIFOs; a per-instance thread replays
+// them block by block through the same analysis the inline path runs.
+// ============================================================================
+
+static bool workerModeFromEnvironment() {
+    const char* value = getenv("AUDIOTRACKER_ANALYSIS");
+    return value && strcmp(value, "worker") == 0;
+}
+
+// AUDIOTRACKER_CHANNEL_MODE=split starts new instances analyzing every input
+// channel; default mixes to mono
+static bool splitChannelsFromEnvironment() {
+    const char* value = getenv("AUDIOTRACKER_CHANNEL_MODE");
+    return value && strcmp(value, "split") == 0;
+}
+
+// AUDIOTRACKER_SPECTRUM=power analyzes the power spectrum; default magnitude
+static dsp::SpectrumValue spectrumValueFromEnvironment() {
+    const char* value = getenv("AUDIOTRACKER_SPECTRUM");
+    return value && strcmp(value, "power") == 0 ? dsp::SpectrumValue::Power : dsp::SpectrumValue::Magnitude;
+}
+
+// AUDIOTRACKER_FRAME_SIZE=1024|2048|4096|8192 picks the analysis frame size
+static uint32_t frameSizeFromEnvironment() {
+    const char* value = getenv("AUDIOTRACKER_FRAME_SIZE");
+    return value ? static_cast<uint32_t>(strtoul(value, nullptr, 10)) : DEFAULT_FRAME_SIZE;
+}
+
+// AUDIOTRACKER_RESOLUTION=multi turns on multi-resolution analysis
+static bool multiResolutionFromEnvironment() {
+    const char* value = getenv("AUDIOTRACKER_RESOLUTION");
+    return value && strcmp(value, "multi") == 0;
+}
+
+class AnalysisWorker {
+public:
+    using AnalyzeFn = std::function<void(const float* const* channels, uint32_t count, double playhead)>;
+    using ResetFn = std::function<void()>;
+    using SkipFn = std::function<void(uint32_t count)>;
+
+    AnalysisWorker(uint32_t channels, AnalyzeFn analyze, ResetFn reset, SkipFn skip)
+        : analyze_(std::move(analyze)), reset_(std::move(reset)), skip_(std::move(skip)), running_(true) {
+        for (uint32_t c = 0; c < channels; ++c) {
+            samples_.emplace_back(new ChannelFifo());
+            scratch_.emplace_back(ANALYSIS_FIFO_SIZE);
+            scratchPointers_[c] = scratch_.back().data();
+        }
+        workerThread_ = std::thread(&AnalysisWorker::workerLoop, this);
+    }
+
+    ~AnalysisWorker() {
+        running_ = false;
+        if (workerThread_.joinable()) {
+            workerThread_.join();
+        }
+    }
+
+    // Audio thread. Wait-free; a block that does not fit is dropped whole so
+    // the FIFO and the block queue never disagree, and the worker skips over
+    // it before the next block it gets.
+    bool push(const float* const* channels, uint32_t count, double playhead) {
+        // Channels are written in lockstep, so the first FIFO speaks for all
+        if (count > samples_[0]->writeAvailable() || blocks_.size() >= BlockQueue::kCapacity) {
+            skippedSamples_ = static_cast<uint32_t>(std::min<uint64_t>(uint64_t(skippedSamples_) + count, UINT32_MAX));
+            return false;
+        }
+
+        for (size_t c = 0; c < samples_.size(); ++c) {
+            samples_[c]->write(channels[c], count);
+        }
+        blocks_.push({ count, skippedSamples_, pendingReset_, playhead });
+        skippedSamples_ = 0;
+        pendingReset_ = false;
+        return true;
+    }
+
+    // Audio thread: the worker resets the analysis before the next block
+    void requestReset() { pendingReset_ = true; }
+
+private:
+    struct BlockMarker {
+        uint32_t count;
+        uint32_t skippedBefore;  // samples of dropped blocks since the previous marker
+        bool resetBefore;
+        double playhead;
+    };
+
+    using BlockQueue = SpscRing<BlockMarker, ANALYSIS_BLOCK_QUEUE_SIZE>;
+    using ChannelFifo = SampleFifo<ANALYSIS_FIFO_SIZE>;
+
+    void workerLoop() {
+        BlockMarker block;
+        while (running_) {
+            if (!blocks_.pop(block)) {
+                std::this_thread::sleep_for(std::chrono::microseconds(WORKER_IDLE_SLEEP_US));
+                continue;
+            }
+
+            // The dropped samples came before any reset requested since
+            if (block.skippedBefore > 0) skip_(block.skippedBefore);
+            if (block.resetBefore) reset_();
+
+            // Samples are published before their marker, so the whole block is there
+            uint32_t count = block.count;
+            for (size_t c = 0; c < samples_.size(); ++c) {
+                count = std::min(count, samples_[c]->read(scratch_[c].data(), block.count));
+            }
+            analyze_(scratchPointers_, count, block.playhead);
+        }
+    }
+
+    AnalyzeFn analyze_;
+    ResetFn reset_;
+    SkipFn skip_;
+
+    std::thread workerThread_;
+    std::atomic<bool> running_;
+
+    // Audio thread (producer) side
+    std::vector<std::unique_ptr<ChannelFifo>> samples_;
+    BlockQueue blocks_;
+    uint32_t skippedSamples_ = 0;
+    bool pendingReset_ = false;
+
+    // Worker thread side
+    std::vector<std::vector<float>> scratch_;
+    const float* scratchPointers_[MAX_CHANNELS] = {};
+};
+
+// ============================================================================
+// Parameters - exposed through clap.params and saved by clap.state
+// ============================================================================
+
+enum ParamId : clap_id {
+    PARAM_FRAME_SIZE,         // index i of the frame size MIN_FRAME_SIZE << i
+    PARAM_SILENCE_THRESHOLD,  // dB
+    PARAM_MIN_F0,             // Hz
+    PARAM_MAX_F0,             // Hz
+    PARAM_STREAM_INTERVAL,    // ms
+    PARAM_MULTI_RESOLUTION,   // 0 off, 1 on
+    PARAM_WIRE_FORMAT,        // WireFormat
+    PARAM_CHANNEL_MODE,       // 0 mix, 1 split
+    PARAM_COUNT
+};
+
+static constexpr uint32_t MIN_FRAME_SIZE = 1024;
+static constexpr uint32_t FRAME_SIZE_COUNT = 4;  // 1024, 2048, 4096, 8192
+
+// Unsupported sizes map to DEFAULT_FRAME_SIZE
+static constexpr double paramForFrameSize(uint32_t size) {
+    for (uint32_t i = 0; i < FRAME_SIZE_COUNT; ++i) {
+        if ((MIN_FRAME_SIZE << i) == size) return i;
+    }
+    return paramForFrameSize(DEFAULT_FRAME_SIZE);
+}
+
+struct ParamSpec {
+    const char* name;
+    double minValue;
+    double maxValue;
+    double defaultValue;
+    clap_param_info_flags flags;
+};
+
+static constexpr ParamSpec paramSpecs[PARAM_COUNT] = {
+    { "Frame Size", 0.0, FRAME_SIZE_COUNT - 1, paramForFrameSize(DEFAULT_FRAME_SIZE),
+      CLAP_PARAM_IS_STEPPED | CLAP_PARAM_IS_ENUM },
+    { "Silence Threshold", -120.0, 0.0, DEFAULT_SILENCE_THRESHOLD_DB, CLAP_PARAM_IS_AUTOMATABLE },
+    { "Min F0", 20.0, 2000.0, DEFAULT_MIN_F0_HZ, CLAP_PARAM_IS_AUTOMATABLE },
+    { "Max F0", 20.0, 2000.0, DEFAULT_MAX_F0_HZ, CLAP_PARAM_IS_AUTOMATABLE },
+    { "Stream Interval", 10.0, 1000.0, DEFAULT_STREAM_INTERVAL_MS, CLAP_PARAM_IS_STEPPED | CLAP_PARAM_IS_AUTOMATABLE },
+    { "Multi-Resolution", 0.0, 1.0, 0.0, CLAP_PARAM_IS_STEPPED },
+    { "Wire Format", 0.0, WIRE_FORMAT_COUNT - 1, 0.0, CLAP_PARAM_IS_STEPPED | CLAP_PARAM_IS_ENUM },
+    { "Channel Mode", 0.0, 1.0, 0.0, CLAP_PARAM_IS_STEPPED | CLAP_PARAM_IS_ENUM },
+};
+
+// Clamped to the parameter's range and rounded if it is stepped; NaN gives the default
+static double clampParam(clap_id id, double value) {
+    const ParamSpec& spec = paramSpecs[id];
+    if (std::isnan(value)) return spec.defaultValue;
+    value = std::clamp(value, spec.minValue, spec.maxValue);
+    return (spec.flags & CLAP_PARAM_IS_STEPPED) ? std::round(value) : value;
+}
+
+static uint32_t frameSizeForParam(double value) {
+    return MIN_FRAME_SIZE << static_cast<uint32_t>(clampParam(PARAM_FRAME_SIZE, value));
+}
+
+// ============================================================================
+// Plugin State
+// ============================================================================
+
+// An analyzer and the scratch for each of its concurrent frame jobs; a frame
+// size or resolution change replaces both together
+struct AnalysisEngine {
+    std::unique_ptr<AudioAnalyzer> analyzer;
+    std::vector<std::unique_ptr<FrameScratch>> scratch;  // one per concurrent analysis job
+};
+
+struct PluginState {
+    PluginState() {
+        for (uint32_t i = 0; i < PARAM_COUNT; ++i) {
+            params[i].store(paramSpecs[i].defaultValue, std::memory_order_relaxed);
+        }
+    }
+
+    ~PluginState() {
+        delete pendingEngine.load(std::memory_order_acquire);
+        delete retiredEngine.load(std::memory_order_acquire);
+    }
+
+    const clap_host_t* host = nullptr;
+    const clap_host_thread_pool_t* threadPool = nullptr;  // null: tasks run serially
+    const clap_host_params_t* hostParams = nullptr;
+
+    AnalysisEngine engine;  // owned by the analysis thread once activated, see beginBlock()
+    uint32_t taskCount = 0;  // analysis tasks of the current chunk
+    uint32_t jobCount = 1;   // jobs sharing them, each with its own scratch
+    std::shared_ptr<MetricsChannel> metrics;  // this instance's queue into the shared StreamingHub
+    std::unique_ptr<AnalysisWorker> worker;    // null when analysis runs inline in process()
+
+    float sampleRate = 44100.0f;
+    double playheadPosition = 0.0;
+
+    // Port layout chosen through audio-ports-config; split analyzes every
+    // channel on its own instead of the downmix. Both are fixed while active:
+    // splitChannels is the Channel Mode parameter as of the last activate().
+    uint32_t channelCount = DEFAULT_CHANNEL_COUNT;
+    bool splitChannels = false;
+    uint32_t maxJobs = 1;  // scratch sets allocated on activate()
+    uint32_t maxFrames = DEFAULT_MAX_BLOCK_SIZE;  // host block size from activate()
+    bool active = false;  // main thread
+
+    // Read on init(), applied to every analyzer created from then on
+    dsp::SpectrumValue spectrumValue = dsp::SpectrumValue::Magnitude;
+
+    // Parameter values; written by whichever thread delivers the events or
+    // loads the state, and picked up by the analysis thread between blocks
+    std::atomic<double> params[PARAM_COUNT];
+    std::atomic<uint32_t> settingsVersion{0};  // bumped by threshold and F0 range changes
+    uint32_t appliedSettingsVersion = 0;       // analysis thread
+
+    // A frame size or resolution change needs new buffers: the main thread builds a whole
+    // engine into pendingEngine, the analysis thread swaps it in at a block
+    // boundary and hands the old one back through retiredEngine for the main
+    // thread to free, so the analysis thread neither allocates nor frees
+    std::atomic<AnalysisEngine*> pendingEngine{nullptr};
+    std::atomic<AnalysisEngine*> retiredEngine{nullptr};
+    uint32_t engineFrameSize = 0;  // main thread: frame size of the newest engine built
+    bool engineMultiResolution = false;  // main thread: its resolution mode
+
+    uint32_t analysisChannels() const { return splitChannels ? channelCount : 1; }
+
+    // Current frame metrics (first analyzed channel)
+    float currentF0 = 0.0f;
+    float currentCentroid = 0.0f;
+    float currentRms = -100.0f;
+
+    // Pre-allocated downmix buffer (mix mode)
+    std::vector<float> monoBuffer;
+
+    // Audio thread; in worker mode the reset is applied by the worker
+    void reset() {
+        if (worker) {
+            worker->requestReset();
+        } else {
+            resetAnalysis();
+        }
+    }
+
+    // Called by whichever thread runs the analysis
+    void resetAnalysis() {
+        currentF0 = 0.0f;
+        currentCentroid = 0.0f;
+        currentRms = -100.0f;
+        engine.analyzer->resetBuffer();
+    }
+
+    // Worker thread: count samples were dropped before reaching the worker
+    void skipAnalysis(uint32_t count) {
+        const uint64_t lost = engine.analyzer->skipSamples(count);
+        metrics->addDropped(lost * engine.analyzer->getChannelCount());
+    }
+
+    double getParam(clap_id id) const { return params[id].load(std::memory_order_relaxed); }
+    void setParam(clap_id id, double value);
+    void applySettings(AudioAnalyzer& analyzer) const;
+
+    std::unique_ptr<AnalysisEngine> createEngine() const;
+    void updateEngine();
+    void beginBlock();
+
+    void analyzeSamples(const float* const* channels, uint32_t count, double playhead, bool useThreadPool);
+    void runTasks(bool useThreadPool);
+    void runJob(uint32_t job);
+
+    void ensureMonoBuffer(uint32_t size) {
+        if (monoBuffer.size() < size) {
+            monoBuffer.resize(size);
+        }
+    }
+};
+
+// Feeds samples to the analyzer and queues a record for every completed frame.
+// useThreadPool may only be set from process(), where request_exec is allowed.
+void PluginState::analyzeSamples(const float* const* channels, uint32_t count, double playhead, bool useThreadPool) {
+    beginBlock();
+
+    AudioAnalyzer* analyzer = engine.analyzer.get();
+    const uint32_t channelsAnalyzed = analyzer->getChannelCount();
+
+    uint32_t offset = 0;
+    while (offset < count) {
+        uint32_t chunk = std::min(count - offset, analyzer->getMaxBlockSize());
+        analyzer->addSamples(channels, offset, chunk);
+        offset += chunk;
+
+        runTasks(useThreadPool);
+        analyzer->completeRecords();
+
+        // Publish in stream order once every frame of the chunk is done, one
+        // record per channel
+        const uint32_t recordCount = analyzer->getRecordCount();
+        for (uint32_t i = 0; i < recordCount; ++i) {
+            const FrameResult& frame = analyzer->getRecord(i);
+            currentF0 = frame.channels[0].f0;
+            currentCentroid = frame.channels[0].centroid;
+            currentRms = frame.channels[0].rms;
+
+            // Queue the frame for the hub (it sends on its own timer)
+            for (uint32_t c = 0; c < channelsAnalyzed; ++c) {
+                metrics->updateMetrics(c, frame.channels[c], playhead, frame.samplePosition);
+            }
+        }
+    }
+}
+
+// Fans the chunk's tasks (one per frame and channel) out over the host's
+// thread pool when there is more than one, otherwise (or if the host
+// declines) runs them here
+void PluginState::runTasks(bool useThreadPool) {
+    taskCount = engine.analyzer->getTaskCount();
+    jobCount = std::min(taskCount, static_cast<uint32_t>(engine.scratch.size()));
+    if (useThreadPool && threadPool && jobCount > 1 && threadPool->request_exec(host, jobCount)) {
+        return;
+    }
+
+    jobCount = 1;
+    runJob(0);
+}
+
+// Job j runs tasks j, j + jobCount, ... with its own scratch
+void PluginState::runJob(uint32_t job) {
+    AudioAnalyzer& analyzer = *engine.analyzer;
+    for (uint32_t task = job; task < taskCount; task += jobCount) {
+        analyzer.runTask(task, *engine.scratch[job]);
+    }
+}
+
+// Any thread that delivers parameter events or loads the state; never
+// allocates. Threshold and F0 range are applied by beginBlock(), a frame
+// size or resolution change by the engine the main thread then builds in
+// updateEngine(). A channel mode change resizes the ports' analysis and the
+// worker's FIFOs, so it asks the host to restart the plugin instead.
+void PluginState::setParam(clap_id id, double value) {
+    if (id >= PARAM_COUNT) return;
+    value = clampParam(id, value);
+    if (params[id].exchange(value, std::memory_order_relaxed) == value) return;
+
+    switch (id) {
+        case PARAM_FRAME_SIZE:
+        case PARAM_MULTI_RESOLUTION:
+            if (host && host->request_callback) host->request_callback(host);
+            break;
+        case PARAM_CHANNEL_MODE:
+            if (host && host->request_restart) host->request_restart(host);
+            break;
+        case PARAM_STREAM_INTERVAL:
+            if (metrics) metrics->setStreamInterval(static_cast<uint32_t>(value));
+            break;
+        case PARAM_WIRE_FORMAT:
+            if (metrics) metrics->setWireFormat(static_cast<WireFormat>(value));
+            break;
+        default:
+            settingsVersion.fetch_add(1, std::memory_order_release);
+            break;
+    }
+}
+
+void PluginState::applySettings(AudioAnalyzer& analyzer) const {
+    analyzer.setSilenceThreshold(static_cast<float>(getParam(PARAM_SILENCE_THRESHOLD)));
+    analyzer.setF0Range(static_cast<float>(getParam(PARAM_MIN_F0)), static_cast<float>(getParam(PARAM_MAX_F0)));
+}
+
+// Main thread: an analyzer for the current parameters and layout, with its scratch
+std::unique_ptr<AnalysisEngine> PluginState::createEngine() const {
+    std::unique_ptr<AnalysisEngine> next(new AnalysisEngine());
+    next->analyzer = createAnalyzer(frameSizeForParam(getParam(PARAM_FRAME_SIZE)));
+    next->analyzer->setSampleRate(sampleRate);
+    next->analyzer->setSpectrumValue(spectrumValue);
+    applySettings(*next->analyzer);
+
+    next->analyzer->configure(analysisChannels(), maxFrames, getParam(PARAM_MULTI_RESOLUTION) != 0.0);
+    for (uint32_t i = 0; i < maxJobs; ++i) {
+        next->scratch.push_back(next->analyzer->createScratch());
+    }
+    return next;
+}
+
+// Main thread: frees the engine the analysis thread retired and, while
+// active, prepares one for a changed frame size or resolution. A prepared
+// engine that was never picked up is replaced.
+void PluginState::updateEngine() {
+    delete retiredEngine.exchange(nullptr, std::memory_order_acq_rel);
+
+    const uint32_t frameSize = frameSizeForParam(getParam(PARAM_FRAME_SIZE));
+    const bool multiResolution = getParam(PARAM_MULTI_RESOLUTION) != 0.0;
+    if (!active || (frameSize == engineFrameSize && multiResolution == engineMultiResolution)) return;
+
+    delete pendingEngine.exchange(createEngine().release(), std::memory_order_acq_rel);
+    engineFrameSize = frameSize;
+    engineMultiResolution = multiResolution;
+}
+
+// Analysis thread, at a block boundary: swaps in a prepared engine, carrying
+// the stream over, then applies threshold and F0 range changes
+void PluginState::beginBlock() {
+    // The retired slot holds one engine; until the main thread has freed the
+    // last one, the swap waits for a later block
+    if (pendingEngine.load(std::memory_order_relaxed) && !retiredEngine.load(std::memory_order_acquire)) {
+        if (AnalysisEngine* next = pendingEngine.exchange(nullptr, std::memory_order_acq_rel)) {
+            next->analyzer->continueFrom(*engine.analyzer);
+            std::swap(engine, *next);
+            retiredEngine.store(next, std::memory_order_release);
+            if (host && host->request_callback) host->request_callback(host);
+
+            // Built before any change this thread has already applied
+            applySettings(*engine.analyzer);
+        }
+    }
+
+    const uint32_t version = settingsVersion.load(std::memory_order_acquire);
+    if (version != appliedSettingsVersion) {
+        applySettings(*engine.analyzer);
+        appliedSettingsVersion = version;
+    }
+}
+
+// ============================================================================
+// CLAP Plugin Implementation
+// ============================================================================
+
+static const clap_plugin_descriptor_t pluginDescriptor = {
+    .clap_version = CLAP_VERSION,
+    .id = "com.audiotracker.clap",
+    .name = "AudioTracker",
+    .vendor = "AudioTracker",
+    .url = "https://github.com/murr/audio-tracker",
+    .manual_url = nullptr,
+    .support_url = nullptr,
+    .version = "1.0.0",
+    .description = "Real-time audio analysis and metrics tracking",
+    .features = (const char*[]){
+        CLAP_PLUGIN_FEATURE_AUDIO_EFFECT,
+        CLAP_PLUGIN_FEATURE_ANALYZER,
+        CLAP_PLUGIN_FEATURE_UTILITY,
+        nullptr
+    }
+};
+
+static bool plugin_init(const clap_plugin_t* plugin);
+static void plugin_destroy(const clap_plugin_t* plugin);
+static bool plugin_activate(const clap_plugin_t* plugin, double sampleRate, uint32_t minFrames, uint32_t maxFrames);
+static void plugin_deactivate(const clap_plugin_t* plugin);
+static bool plugin_start_processing(const clap_plugin_t* plugin);
+static void plugin_stop_processing(const clap_plugin_t* plugin);
+static void plugin_reset(const clap_plugin_t* plugin);
+static clap_process_status plugin_process(const clap_plugin_t* plugin, const clap_process_t* process);
+static const void* plugin_get_extension(const clap_plugin_t* plugin, const char* id);
+static void plugin_on_main_thread(const clap_plugin_t* plugin);
+
+// Audio ports extension
+static uint32_t audio_ports_count(const clap_plugin_t* /*plugin*/, bool /*isInput*/) {
+    return 1;
+}
+
+static const char* portTypeForChannels(uint32_t channels) {
+    switch (channels) {
+        case 1: return CLAP_PORT_MONO;
+        case 2: return CLAP_PORT_STEREO;
+        default: return CLAP_PORT_SURROUND;
+    }
+}
+
+static bool audio_ports_get(const clap_plugin_t* plugin, uint32_t index, bool isInput, clap_audio_port_info_t* info) {
+    if (index != 0) return false;
+    auto* state = static_cast<PluginState*>(plugin->plugin_data);
+
+    info->id = isInput ? 0 : 1;
+    snprintf(info->name, sizeof(info->name), "%s", isInput ? "Input" : "Output");
+    info->flags = CLAP_AUDIO_PORT_IS_MAIN;
+    info->channel_count = state->channelCount;
+    info->port_type = portTypeForChannels(state->channelCount);
+    info->in_place_pair = isInput ? 1 : 0;
+
+    return true;
+}
+
+static const clap_plugin_audio_ports_t audioPortsExtension = {
+    .count = audio_ports_count,
+    .get = audio_ports_get
+};
+
+// Audio ports config extension - one in/out pair per supported layout
+struct PortLayout {
+    const char* name;
+    uint32_t channels;
+};
+
+static constexpr PortLayout portLayouts[] = {
+    { "Mono", 1 },
+    { "Stereo", 2 },
+    { "5.1", 6 },
+    { "7.1", 8 },
+};
+
+static uint32_t audio_ports_config_count(const clap_plugin_t* /*plugin*/) {
+    return sizeof(portLayouts) / sizeof(portLayouts[0]);
+}
+
+static bool audio_ports_config_get(const clap_plugin_t* /*plugin*/, uint32_t index, clap_audio_ports_config_t* config) {
+    if (index >= audio_ports_config_count(nullptr)) return false;
+    const PortLayout& layout = portLayouts[index];
+
+    config->id = index;
+    snprintf(config->name, sizeof(config->name), "%s", layout.name);
+    config->input_port_count = 1;
+    config->output_port_count = 1;
+    config->has_main_input = true;
+    config->main_input_channel_count = layout.channels;
+    config->main_input_port_type = portTypeForChannels(layout.channels);
+    config->has_main_output = true;
+    config->main_output_channel_count = layout.channels;
+    config->main_output_port_type = portTypeForChannels(layout.channels);
+
+    return true;
+}
+
+// Only called while deactivated; the analyzer is sized on the next activate()
+static bool audio_ports_config_select(const clap_plugin_t* plugin, clap_id configId) {
+    if (configId >= audio_ports_config_count(nullptr)) return false;
+    auto* state = static_cast<PluginState*>(plugin->plugin_data);
+    state->channelCount = portLayouts[configId].channels;
+    return true;
+}
+
+static const clap_plugin_audio_ports_config_t audioPortsConfigExtension = {
+    .count = audio_ports_config_count,
+    .get = audio_ports_config_get,
+    .select = audio_ports_config_select
+};
+
+// Tail extension - report infinite tail so we're always processed
+static uint32_t tail_get(const clap_plugin_t* /*plugin*/) {
+    return UINT32_MAX;  // Infinite tail - never stop processing us
+}
+
+static const clap_plugin_tail_t tailExtension = {
+    .get = tail_get
+};
+
+// Thread pool extension - called on the host's workers during request_exec()
+static void thread_pool_exec(const clap_plugin_t* plugin, uint32_t taskIndex) {
+    auto* state = static_cast<PluginState*>(plugin->plugin_data);
+    state->runJob(taskIndex);
+}
+
+static const clap_plugin_thread_pool_t threadPoolExtension = {
+    .exec = thread_pool_exec
+};
+
+// Params extension - values change through process() or flush() events and
+// take effect from the next analyzed block
+static void handleParamEvents(PluginState* state, const clap_input_events_t* events) {
+    if (!events) return;
+    const uint32_t count = events->size(events);
+    for (uint32_t i = 0; i < count; ++i) {
+        const clap_event_header_t* header = events->get(events, i);
+        if (header->space_id != CLAP_CORE_EVENT_SPACE_ID || header->type != CLAP_EVENT_PARAM_VALUE) continue;
+        const auto* event = reinterpret_cast<const clap_event_param_value_t*>(header);
+        state->setParam(event->param_id, event->value);
+    }
+}
+
+static uint32_t params_count(const clap_plugin_t* /*plugin*/) {
+    return PARAM_COUNT;
+}
+
+static bool params_get_info(const clap_plugin_t* /*plugin*/, uint32_t index, clap_param_info_t* info) {
+    if (index >= PARAM_COUNT) return false;
+    const ParamSpec& spec = paramSpecs[index];
+
+    info->id = index;
+    info->flags = spec.flags;
+    info->cookie = nullptr;
+    snprintf(info->name, sizeof(info->name), "%s", spec.name);
+    info->module[0] = '\0';
+    info->min_value = spec.minValue;
+    info->max_value = spec.maxValue;
+    info->default_value = spec.defaultValue;
+
+    return true;
+}
+
+static bool params_get_value(const clap_plugin_t* plugin, clap_id id, double* value) {
+    if (id >= PARAM_COUNT) return false;
+    auto* state = static_cast<PluginState*>(plugin->plugin_data);
+    *value = state->getParam(id);
+    return true;
+}
+
+static bool params_value_to_text(const clap_plugin_t* /*plugin*/, clap_id id, double value, char* text, uint32_t size) {
+    switch (id) {
+        case PARAM_FRAME_SIZE:        snprintf(text, size, "%u", frameSizeForParam(value)); break;
+        case PARAM_SILENCE_THRESHOLD: snprintf(text, size, "%.1f dB", value); break;
+        case PARAM_MIN_F0:
+        case PARAM_MAX_F0:            snprintf(text, size, "%.0f Hz", value); break;
+        case PARAM_STREAM_INTERVAL:   snprintf(text, size, "%.0f ms", value); break;
+        case PARAM_MULTI_RESOLUTION:  snprintf(text, size, "%s", value != 0.0 ? "On" : "Off"); break;
+        case PARAM_WIRE_FORMAT:       snprintf(text, size, "%s", value != 0.0 ? "Binary" : "JSON"); break;
+        case PARAM_CHANNEL_MODE:      snprintf(text, size, "%s", value != 0.0 ? "Split" : "Mix"); break;
+        default: return false;
+    }
+    return true;
+}
+
+// Frame size is entered in samples, multi-resolution as On/Off, wire format
+// as JSON/Binary, channel mode as Mix/Split (or any of those three as its
+// index), everything else in its unit
+static bool params_text_to_value(const clap_plugin_t* /*plugin*/, clap_id id, const char* text, double* value) {
+    if (id >= PARAM_COUNT) return false;
+    if (id == PARAM_MULTI_RESOLUTION && (strcmp(text, "On") == 0 || strcmp(text, "Off") == 0)) {
+        *value = strcmp(text, "On") == 0 ? 1.0 : 0.0;
+        return true;
+    }
+    if (id == PARAM_WIRE_FORMAT && (strcmp(text, "Binary") == 0 || strcmp(text, "JSON") == 0)) {
+        *value = strcmp(text, "Binary") == 0 ? 1.0 : 0.0;
+        return true;
+    }
+    if (id == PARAM_CHANNEL_MODE && (strcmp(text, "Split") == 0 || strcmp(text, "Mix") == 0)) {
+        *value = strcmp(text, "Split") == 0 ? 1.0 : 0.0;
+        return true;
+    }
+    char* end = nullptr;
+    const double parsed = strtod(text, &end);
+    if (end == text) return false;
+    *value = id == PARAM_FRAME_SIZE ? paramForFrameSize(static_cast<uint32_t>(parsed)) : clampParam(id, parsed);
+    return true;
+}
+
+static void params_flush(const clap_plugin_t* plugin, const clap_input_events_t* in, const clap_output_events_t* /*out*/) {
+    handleParamEvents(static_cast<PluginState*>(plugin->plugin_data), in);
+}
+
+static const clap_plugin_params_t paramsExtension = {
+    .count = params_count,
+    .get_info = params_get_info,
+    .get_value = params_get_value,
+    .value_to_text = params_value_to_text,
+    .text_to_value = params_text_to_value,
+    .flush = params_flush
+};
+
+// State extension - STATE_VERSION, the parameter count, then one double per
+// parameter in ParamId order, all in native byte order
+static constexpr uint32_t STATE_VERSION = 1;
+
+static bool writeStream(const clap_ostream_t* stream, const void* data, uint64_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        const int64_t written = stream->write(stream, bytes, size);
+        if (written <= 0) return false;
+        bytes += written;
+        size -= static_cast<uint64_t>(written);
+    }
+    return true;
+}
+
+static bool readStream(const clap_istream_t* stream, void* data, uint64_t size) {
+    char* bytes = static_cast<char*>(data);
+    while (size > 0) {
+        const int64_t read = stream->read(stream, bytes, size);
+        if (read <= 0) return false;
+        bytes += read;
+        size -= static_cast<uint64_t>(read);
+    }
+    return true;
+}
+
+static bool state_save(const clap_plugin_t* plugin, const clap_ostream_t* stream) {
+    auto* state = static_cast<PluginState*>(plugin->plugin_data);
+    const uint32_t header[2] = { STATE_VERSION, PARAM_COUNT };
+    double values[PARAM_COUNT];
+    for (uint32_t i = 0; i < PARAM_COUNT; ++i) {
+        values[i] = state->getParam(i);
+    }
+    return writeStream(stream, header, sizeof(header)) && writeStream(stream, values, sizeof(values));
+}
+
+// Parameters missing from an older state keep their current values; extra
+// ones from a newer build are ignored
+static bool state_load(const clap_plugin_t* plugin, const clap_istream_t* stream) {
+    auto* state = static_cast<PluginState*>(plugin->plugin_data);
+    uint32_t header[2];
+    if (!readStream(stream, header, sizeof(header)) || header[0] != STATE_VERSION) return false;
+
+    const uint32_t count = std::min<uint32_t>(header[1], PARAM_COUNT);
+    double values[PARAM_COUNT];
+    if (!readStream(stream, values, count * sizeof(double))) return false;
+    for (uint32_t i = 0; i < count; ++i) {
+        state->setParam(i, values[i]);
+    }
+
+    state->updateEngine();
+    if (state->hostParams && state->hostParams->rescan) {
+        state->hostParams->rescan(state->host, CLAP_PARAM_RESCAN_VALUES);
+    }
+    return true;
+}
+
+static const clap_plugin_state_t stateExtension = {
+    .save = state_save,
+    .load = state_load
+};
+
+static bool plugin_init(const clap_plugin_t* plugin) {
+    auto* state = static_cast<PluginState*>(plugin->plugin_data);
+
+    // Host extensions may only be queried from init() onwards
+    if (state->host && state->host->get_extension) {
+        state->threadPool = static_cast<const clap_host_thread_pool_t*>(
+            state->host->get_extension(state->host, CLAP_EXT_THREAD_POOL));
+        state->hostParams = static_cast<const clap_host_params_t*>(
+            state->host->get_extension(state->host, CLAP_EXT_PARAMS));
+    }
+    state->maxJobs = state->threadPool && state->threadPool->request_exec ? MAX_ANALYSIS_JOBS : 1;
+    if (state->maxJobs == 1) state->threadPool = nullptr;
+    state->params[PARAM_FRAME_SIZE].store(paramForFrameSize(frameSizeFromEnvironment()), std::memory_order_relaxed);
+    state->params[PARAM_MULTI_RESOLUTION].store(multiResolutionFromEnvironment() ? 1.0 : 0.0, std::memory_order_relaxed);
+    state->params[PARAM_WIRE_FORMAT].store(static_cast<double>(wireFormatFromEnvironment()), std::memory_order_relaxed);
+    state->params[PARAM_CHANNEL_MODE].store(splitChannelsFromEnvironment() ? 1.0 : 0.0, std::memory_order_relaxed);
+    state->spectrumValue = spectrumValueFromEnvironment();
+
+    state->metrics = StreamingHub::acquire().openChannel();
+    state->metrics->setStreamInterval(static_cast<uint32_t>(state->getParam(PARAM_STREAM_INTERVAL)));
+    state->metrics->setWireFormat(static_cast<WireFormat>(state->getParam(PARAM_WIRE_FORMAT)));
+    return true;
+}
+
+static void plugin_destroy(const clap_plugin_t* plugin) {
+    auto* state = static_cast<PluginState*>(plugin->plugin_data);
+    state->worker.reset();
+    if (state->metrics) {
+        state->metrics->close();
+        StreamingHub::release();
+    }
+    delete state;
+}
+
+static bool plugin_activate(const clap_plugin_t* plugin, double sampleRate, uint32_t /*minFrames*/, uint32_t maxFrames) {
+    auto* state = static_cast<PluginState*>(plugin->plugin_data);
+    state->sampleRate = static_cast<float>(sampleRate);
+    state->maxFrames = maxFrames;
+
+    // Channel layout and mode only change while deactivated, so size everything
+    // for them here. Nothing analyzes yet, so the engine is installed directly.
+    state->splitChannels = state->getParam(PARAM_CHANNEL_MODE) != 0.0;
+    const uint32_t channels = state->analysisChannels();
+    delete state->pendingEngine.exchange(nullptr, std::memory_order_acq_rel);
+    delete state->retiredEngine.exchange(nullptr, std::memory_order_acq_rel);
+    state->appliedSettingsVersion = state->settingsVersion.load(std::memory_order_acquire);
+    state->engine = std::move(*state->createEngine());
+    state->engineFrameSize = state->engine.analyzer->getFrameSize();
+    state->engineMultiResolution = state->engine.analyzer->isMultiResolution();
+    state->active = true;
+    state->monoBuffer.resize(maxFrames);
+
+    if (workerModeFromEnvironment()) {
+        state->resetAnalysis();
+        state->worker.reset(new AnalysisWorker(
+            channels,
+            [state](const float* const* channels, uint32_t count, double playhead) {
+                state->analyzeSamples(channels, count, playhead, false);
+            },
+            [state]() { state->resetAnalysis(); },
+            [state](uint32_t count) { state->skipAnalysis(count); }));
+    }
+    return true;
+}
+
+static void plugin_deactivate(const clap_plugin_t* plugin) {
+    auto* state = static_cast<PluginState*>(plugin->plugin_data);
+    state->worker.reset();  // joins the worker thread
+    state->active = false;
+}
+
+static bool plugin_start_processing(const clap_plugin_t* plugin) {
+    auto* state = static_cast<PluginState*>(plugin->plugin_data);
+    state->reset();
+    return true;
+}
+
+static void plugin_stop_processing(const clap_plugin_t* /*plugin*/) {
+}
+
+static void plugin_reset(const clap_plugin_t* plugin) {
+    auto* state = static_cast<PluginState*>(plugin->plugin_data);
+    state->reset();
+}
+
+static clap_process_status plugin_process(const clap_plugin_t* plugin, const clap_process_t* process) {
+    auto* state = static_cast<PluginState*>(plugin->plugin_data);
+    handleParamEvents(state, process->in_events);
+
+    const uint32_t frameCount = process->frames_count;
+    if (frameCount == 0) {
+        return CLAP_PROCESS_CONTINUE;
+    }
+
+    // Get transport info
+    if (process->transport) {
+        if (process->transport->flags & CLAP_TRANSPORT_HAS_SECONDS_TIMELINE) {
+            state->playheadPosition = static_cast<double>(process->transport->song_pos_seconds) / CLAP_SECTIME_FACTOR;
+        }
+    }
+
+    // Check for valid audio buffers
+    if (!process->audio_inputs || !process->audio_outputs ||
+        process->audio_inputs_count == 0 || process->audio_outputs_count == 0) {
+        return CLAP_PROCESS_CONTINUE;
+    }
+
+    const clap_audio_buffer_t& input = process->audio_inputs[0];
+    const clap_audio_buffer_t& output = process->audio_outputs[0];
+    const uint32_t channels = std::min({ input.channel_count, output.channel_count, state->channelCount });
+
+    if (!input.data32 || !output.data32 || channels == 0) {
+        return CLAP_PROCESS_CONTINUE;
+    }
+
+    const float* const* in = input.data32;
+    float* const* out = output.data32;
+    for (uint32_t c = 0; c < channels; ++c) {
+        if (!in[c] || !out[c]) return CLAP_PROCESS_CONTINUE;
+    }
+
+    // Pass through audio
+    for (uint32_t c = 0; c < channels; ++c) {
+        if (in[c] != out[c]) memcpy(out[c], in[c], frameCount * sizeof(float));
+    }
+
+    // Split mode analyzes the host's channels directly, mix mode their average
+    const float* mixed[1] = { nullptr };
+    const float* const* analyzed = in;
+    if (state->splitChannels) {
+        if (channels < state->analysisChannels()) {
+            return CLAP_PROCESS_CONTINUE;  // fewer channels than the selected layout
+        }
+    } else {
+        // Ensure mono buffer is large enough
+        state->ensureMonoBuffer(frameCount);
+
+        // Mix to mono
+        float* mono = state->monoBuffer.data();
+        memcpy(mono, in[0], frameCount * sizeof(float));
+        if (channels > 1) {
+            for (uint32_t c = 1; c < channels; ++c) {
+                for (uint32_t i = 0; i < frameCount; ++i) {
+                    mono[i] += in[c][i];
+                }
+            }
+            const float gain = 1.0f / channels;
+            for (uint32_t i = 0; i < frameCount; ++i) {
+                mono[i] *= gain;
+            }
+        }
+        mixed[0] = mono;
+        analyzed = mixed;
+    }
+
+    if (state->worker) {
+        // Worker mode: hand the block over. A full FIFO drops it; the worker
+        // counts the lost records and restarts framing after the gap.
+        state->worker->push(analyzed, frameCount, state->playheadPosition);
+    } else {
+        state->analyzeSamples(analyzed, frameCount, state->playheadPosition, true);
+    }
+
+    return CLAP_PROCESS_CONTINUE;
+}
+
+static const void* plugin_get_extension(const clap_plugin_t* /*plugin*/, const char* id) {
+    if (strcmp(id, CLAP_EXT_AUDIO_PORTS) == 0) {
+        return &audioPortsExtension;
+    }
+    if (strcmp(id, CLAP_EXT_AUDIO_PORTS_CONFIG) == 0) {
+        return &audioPortsConfigExtension;
+    }
+    if (strcmp(id, CLAP_EXT_TAIL) == 0) {
+        return &tailExtension;
+    }
+    if (strcmp(id, CLAP_EXT_THREAD_POOL) == 0) {
+        return &threadPoolExtension;
+    }
+    if (strcmp(id, CLAP_EXT_PARAMS) == 0) {
+        return &paramsExtension;
+    }
+    if (strcmp(id, CLAP_EXT_STATE) == 0) {
+        return &stateExtension;
+    }
+    return nullptr;
+}
+
+// Requested after a frame size change and after every engine swap
+static void plugin_on_main_thread(const clap_plugin_t* plugin) {
+    auto* state = static_cast<PluginState*>(plugin->plugin_data);
+    state->updateEngine();
+}
+
+static const clap_plugin_t* create_plugin(const clap_plugin_factory_t* /*factory*/,
+                                          const clap_host_t* host,
+                                          const char* pluginId) {
+    if (strcmp(pluginId, pluginDescriptor.id) != 0) {
+        return nullptr;
+    }
+
+    auto* state = new PluginState();
+    state->host = host;
+
+    auto* plugin = new clap_plugin_t{
+        .desc = &pluginDescriptor,
+        .plugin_data = state,
+        .init = plugin_init,
+        .destroy = plugin_destroy,
+        .activate = plugin_activate,
+        .deactivate = plugin_deactivate,
+        .start_processing = plugin_start_processing,
+        .stop_processing = plugin_stop_processing,
+        .reset = plugin_reset,
+        .process = plugin_process,
+        .get_extension = plugin_get_extension,
+        .on_main_thread = plugin_on_main_thread
+    };
+
+    return plugin;
+}
+
+static uint32_t factory_get_plugin_count(const clap_plugin_factory_t* /*factory*/) {
+    return 1;
+}
+
+static const clap_plugin_descriptor_t* factory_get_plugin_descriptor(const clap_plugin_factory_t* /*factory*/, uint32_t index) {
+    return index == 0 ? &pluginDescriptor : nullptr;
+}
+
+static const clap_plugin_t* factory_create_plugin(const clap_plugin_factory_t* factory,
+                                                   const clap_host_t* host,
+                                                   const char* pluginId) {
+    return create_plugin(factory, host, pluginId);
+}
+
+static const clap_plugin_factory_t pluginFactory = {
+    .get_plugin_count = factory_get_plugin_count,
+    .get_plugin_descriptor = factory_get_plugin_descriptor,
+    .create_plugin = factory_create_plugin
+};
+
+static bool entry_init(const char* /*pluginPath*/) {
+    return true;
+}
+
+static void entry_deinit(void) {
+}
+
+static const void* entry_get_factory(const char* factoryId) {
+    if (strcmp(factoryId, CLAP_PLUGIN_FACTORY_ID) == 0) {
+        return &pluginFactory;
+    }
+    return nullptr;
+}
+
+extern "C" CLAP_EXPORT const clap_plugin_entry_t clap_entry = {
+    .clap_version = CLAP_VERSION,
+    .init = entry_init,
+    .deinit = entry_deinit,
+    .get_factory = entry_get_factory
+};
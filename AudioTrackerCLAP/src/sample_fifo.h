@@ -0,0 +1,63 @@
+// AudioTracker sample FIFO
+// Wait-free single-producer/single-consumer FIFO of float samples with bulk
+// write/read. Both sides copy at most two contiguous segments per call, so the
+// audio thread's cost is a memcpy of the block it hands over.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+template <uint32_t Capacity>
+class SampleFifo {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    static constexpr uint32_t kCapacity = Capacity;
+
+    // Producer only: space the producer can rely on until it writes
+    uint32_t writeAvailable() const {
+        return Capacity - (head_.load(std::memory_order_relaxed) - tail_.load(std::memory_order_acquire));
+    }
+
+    // Producer only: all or nothing, false if count samples do not fit
+    bool write(const float* samples, uint32_t count) {
+        if (count > writeAvailable()) return false;
+
+        const uint32_t head = head_.load(std::memory_order_relaxed);
+        const uint32_t start = head & kMask;
+        const uint32_t first = std::min(count, Capacity - start);
+        memcpy(buffer_ + start, samples, first * sizeof(float));
+        memcpy(buffer_, samples + first, (count - first) * sizeof(float));
+        head_.store(head + count, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only
+    uint32_t readAvailable() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_relaxed);
+    }
+
+    // Consumer only: reads up to count samples, returns how many were read
+    uint32_t read(float* samples, uint32_t count) {
+        count = std::min(count, readAvailable());
+
+        const uint32_t tail = tail_.load(std::memory_order_relaxed);
+        const uint32_t start = tail & kMask;
+        const uint32_t first = std::min(count, Capacity - start);
+        memcpy(samples, buffer_ + start, first * sizeof(float));
+        memcpy(samples + first, buffer_, (count - first) * sizeof(float));
+        tail_.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+private:
+    static constexpr uint32_t kMask = Capacity - 1;
+
+    // Free-running indices, as in SpscRing
+    alignas(64) std::atomic<uint32_t> head_{0};
+    alignas(64) std::atomic<uint32_t> tail_{0};
+    alignas(64) float buffer_[Capacity];
+};
@@ -0,0 +1,250 @@
+// AudioTracker spectrum kernel
+// One pass over a half spectrum in the fft_backend.h layout that produces the
+// spectrum together with everything AudioAnalyzer derives from it:
+//   - spectrum[i] = sqrt((real[i]^2 + imag[i]^2) * scale) for every bin, or
+//     the scaled power (real[i]^2 + imag[i]^2) * scale with SpectrumValue::Power
+//   - sum and bin-index-weighted sum of the values over bins 1..n-1
+//     (the spectral centroid is binWidth * weightedSum / sum)
+//   - the largest value in [peakFirst, peakLast] and the first bin holding
+//     it, or peakFirst when no bin there is above zero (F0 search); the bin is
+//     the same for both value kinds since sqrt is monotonic
+//
+// Vector width is chosen from the target ISA, independently of the FFT
+// backend: AVX2 (8 bins), SSE2 (4), AArch64 NEON (4), else plain scalar.
+// Results match the scalar loop up to summation order.
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define AUDIOTRACKER_SPECTRUM_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define AUDIOTRACKER_SPECTRUM_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define AUDIOTRACKER_SPECTRUM_NEON 1
+#endif
+
+namespace dsp {
+
+enum class SpectrumValue {
+    Magnitude,
+    Power   // skips the square root
+};
+
+struct SpectrumSummary {
+    float sum = 0.0f;
+    float weightedSum = 0.0f;
+    float peak = 0.0f;
+    uint32_t peakIndex = 0;
+};
+
+namespace detail {
+
+template <SpectrumValue Value, bool TrackPeak>
+inline void summarizeScalar(const float* real, const float* imag, float* spectrum, float scale,
+                            uint32_t begin, uint32_t end, SpectrumSummary& summary) {
+    for (uint32_t i = begin; i < end; ++i) {
+        const float power = (real[i] * real[i] + imag[i] * imag[i]) * scale;
+        const float value = Value == SpectrumValue::Power ? power : sqrtf(power);
+        spectrum[i] = value;
+        summary.sum += value;
+        summary.weightedSum += static_cast<float>(i) * value;
+        if (TrackPeak && value > summary.peak) {
+            summary.peak = value;
+            summary.peakIndex = i;
+        }
+    }
+}
+
+// Folds per-lane peaks into the summary: largest value, lowest bin on ties
+inline void mergePeaks(const float* peaks, const float* indices, uint32_t lanes, SpectrumSummary& summary) {
+    for (uint32_t lane = 0; lane < lanes; ++lane) {
+        const uint32_t index = static_cast<uint32_t>(indices[lane]);
+        if (peaks[lane] > summary.peak || (peaks[lane] == summary.peak && index < summary.peakIndex)) {
+            summary.peak = peaks[lane];
+            summary.peakIndex = index;
+        }
+    }
+}
+
+#if defined(AUDIOTRACKER_SPECTRUM_AVX2)
+
+template <SpectrumValue Value, bool TrackPeak>
+inline void summarizeRange(const float* real, const float* imag, float* spectrum, float scale,
+                           uint32_t begin, uint32_t end, SpectrumSummary& summary) {
+    constexpr uint32_t kLanes = 8;
+    const __m256 scaleV = _mm256_set1_ps(scale);
+    const __m256 stepV = _mm256_set1_ps(static_cast<float>(kLanes));
+    __m256 indexV = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(begin)),
+                                  _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7));
+    __m256 sumV = _mm256_setzero_ps();
+    __m256 weightedV = _mm256_setzero_ps();
+    __m256 peakV = _mm256_setzero_ps();
+    __m256 peakIndexV = _mm256_set1_ps(static_cast<float>(summary.peakIndex));
+
+    uint32_t i = begin;
+    for (; i + kLanes <= end; i += kLanes) {
+        const __m256 re = _mm256_loadu_ps(real + i);
+        const __m256 im = _mm256_loadu_ps(imag + i);
+        const __m256 power = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(re, re), _mm256_mul_ps(im, im)), scaleV);
+        const __m256 value = Value == SpectrumValue::Power ? power : _mm256_sqrt_ps(power);
+        _mm256_storeu_ps(spectrum + i, value);
+
+        sumV = _mm256_add_ps(sumV, value);
+        weightedV = _mm256_add_ps(weightedV, _mm256_mul_ps(indexV, value));
+        if (TrackPeak) {
+            const __m256 greater = _mm256_cmp_ps(value, peakV, _CMP_GT_OQ);
+            peakV = _mm256_blendv_ps(peakV, value, greater);
+            peakIndexV = _mm256_blendv_ps(peakIndexV, indexV, greater);
+        }
+        indexV = _mm256_add_ps(indexV, stepV);
+    }
+
+    alignas(32) float sums[kLanes], weighted[kLanes];
+    _mm256_store_ps(sums, sumV);
+    _mm256_store_ps(weighted, weightedV);
+    for (uint32_t lane = 0; lane < kLanes; ++lane) {
+        summary.sum += sums[lane];
+        summary.weightedSum += weighted[lane];
+    }
+    if (TrackPeak) {
+        alignas(32) float peaks[kLanes], indices[kLanes];
+        _mm256_store_ps(peaks, peakV);
+        _mm256_store_ps(indices, peakIndexV);
+        mergePeaks(peaks, indices, kLanes, summary);
+    }
+
+    summarizeScalar<Value, TrackPeak>(real, imag, spectrum, scale, i, end, summary);
+}
+
+#elif defined(AUDIOTRACKER_SPECTRUM_SSE2)
+
+template <SpectrumValue Value, bool TrackPeak>
+inline void summarizeRange(const float* real, const float* imag, float* spectrum, float scale,
+                           uint32_t begin, uint32_t end, SpectrumSummary& summary) {
+    constexpr uint32_t kLanes = 4;
+    const __m128 scaleV = _mm_set1_ps(scale);
+    const __m128 stepV = _mm_set1_ps(static_cast<float>(kLanes));
+    __m128 indexV = _mm_add_ps(_mm_set1_ps(static_cast<float>(begin)), _mm_setr_ps(0, 1, 2, 3));
+    __m128 sumV = _mm_setzero_ps();
+    __m128 weightedV = _mm_setzero_ps();
+    __m128 peakV = _mm_setzero_ps();
+    __m128 peakIndexV = _mm_set1_ps(static_cast<float>(summary.peakIndex));
+
+    uint32_t i = begin;
+    for (; i + kLanes <= end; i += kLanes) {
+        const __m128 re = _mm_loadu_ps(real + i);
+        const __m128 im = _mm_loadu_ps(imag + i);
+        const __m128 power = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im)), scaleV);
+        const __m128 value = Value == SpectrumValue::Power ? power : _mm_sqrt_ps(power);
+        _mm_storeu_ps(spectrum + i, value);
+
+        sumV = _mm_add_ps(sumV, value);
+        weightedV = _mm_add_ps(weightedV, _mm_mul_ps(indexV, value));
+        if (TrackPeak) {
+            // No blendv before SSE4.1
+            const __m128 greater = _mm_cmpgt_ps(value, peakV);
+            peakV = _mm_or_ps(_mm_and_ps(greater, value), _mm_andnot_ps(greater, peakV));
+            peakIndexV = _mm_or_ps(_mm_and_ps(greater, indexV), _mm_andnot_ps(greater, peakIndexV));
+        }
+        indexV = _mm_add_ps(indexV, stepV);
+    }
+
+    alignas(16) float sums[kLanes], weighted[kLanes];
+    _mm_store_ps(sums, sumV);
+    _mm_store_ps(weighted, weightedV);
+    for (uint32_t lane = 0; lane < kLanes; ++lane) {
+        summary.sum += sums[lane];
+        summary.weightedSum += weighted[lane];
+    }
+    if (TrackPeak) {
+        alignas(16) float peaks[kLanes], indices[kLanes];
+        _mm_store_ps(peaks, peakV);
+        _mm_store_ps(indices, peakIndexV);
+        mergePeaks(peaks, indices, kLanes, summary);
+    }
+
+    summarizeScalar<Value, TrackPeak>(real, imag, spectrum, scale, i, end, summary);
+}
+
+#elif defined(AUDIOTRACKER_SPECTRUM_NEON)
+
+template <SpectrumValue Value, bool TrackPeak>
+inline void summarizeRange(const float* real, const float* imag, float* spectrum, float scale,
+                           uint32_t begin, uint32_t end, SpectrumSummary& summary) {
+    constexpr uint32_t kLanes = 4;
+    const float laneOffsets[kLanes] = { 0.0f, 1.0f, 2.0f, 3.0f };
+    const float32x4_t scaleV = vdupq_n_f32(scale);
+    const float32x4_t stepV = vdupq_n_f32(static_cast<float>(kLanes));
+    float32x4_t indexV = vaddq_f32(vdupq_n_f32(static_cast<float>(begin)), vld1q_f32(laneOffsets));
+    float32x4_t sumV = vdupq_n_f32(0.0f);
+    float32x4_t weightedV = vdupq_n_f32(0.0f);
+    float32x4_t peakV = vdupq_n_f32(0.0f);
+    float32x4_t peakIndexV = vdupq_n_f32(static_cast<float>(summary.peakIndex));
+
+    uint32_t i = begin;
+    for (; i + kLanes <= end; i += kLanes) {
+        const float32x4_t re = vld1q_f32(real + i);
+        const float32x4_t im = vld1q_f32(imag + i);
+        const float32x4_t power = vmulq_f32(vaddq_f32(vmulq_f32(re, re), vmulq_f32(im, im)), scaleV);
+        const float32x4_t value = Value == SpectrumValue::Power ? power : vsqrtq_f32(power);
+        vst1q_f32(spectrum + i, value);
+
+        sumV = vaddq_f32(sumV, value);
+        weightedV = vaddq_f32(weightedV, vmulq_f32(indexV, value));
+        if (TrackPeak) {
+            const uint32x4_t greater = vcgtq_f32(value, peakV);
+            peakV = vbslq_f32(greater, value, peakV);
+            peakIndexV = vbslq_f32(greater, indexV, peakIndexV);
+        }
+        indexV = vaddq_f32(indexV, stepV);
+    }
+
+    summary.sum += vaddvq_f32(sumV);
+    summary.weightedSum += vaddvq_f32(weightedV);
+    if (TrackPeak) {
+        float peaks[kLanes], indices[kLanes];
+        vst1q_f32(peaks, peakV);
+        vst1q_f32(indices, peakIndexV);
+        mergePeaks(peaks, indices, kLanes, summary);
+    }
+
+    summarizeScalar<Value, TrackPeak>(real, imag, spectrum, scale, i, end, summary);
+}
+
+#else
+
+template <SpectrumValue Value, bool TrackPeak>
+inline void summarizeRange(const float* real, const float* imag, float* spectrum, float scale,
+                           uint32_t begin, uint32_t end, SpectrumSummary& summary) {
+    summarizeScalar<Value, TrackPeak>(real, imag, spectrum, scale, begin, end, summary);
+}
+
+#endif
+
+} // namespace detail
+
+// n bins of split-complex input; requires 1 <= peakFirst <= peakLast < n
+template <SpectrumValue Value = SpectrumValue::Magnitude>
+inline SpectrumSummary summarizeSpectrum(const float* real, const float* imag, float* spectrum,
+                                         uint32_t n, float scale, uint32_t peakFirst, uint32_t peakLast) {
+    SpectrumSummary summary;
+    summary.peakIndex = peakFirst;
+
+    // Bin 0 packs DC and Nyquist: it gets a value but stays out of the sums
+    const float power = (real[0] * real[0] + imag[0] * imag[0]) * scale;
+    spectrum[0] = Value == SpectrumValue::Power ? power : sqrtf(power);
+
+    // Three runs over consecutive bins, so the data is still read exactly once
+    detail::summarizeRange<Value, false>(real, imag, spectrum, scale, 1, peakFirst, summary);
+    detail::summarizeRange<Value, true>(real, imag, spectrum, scale, peakFirst, peakLast + 1, summary);
+    detail::summarizeRange<Value, false>(real, imag, spectrum, scale, peakLast + 1, n, summary);
+    return summary;
+}
+
+} // namespace dsp
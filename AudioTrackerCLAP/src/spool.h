@@ -0,0 +1,112 @@
+// AudioTracker upload spool
+// Bounded append-only file of encoded batches that could not be uploaded.
+// Batches are replayed oldest first; once everything has been replayed the
+// file is truncated back to zero, so it only grows while the server is down.
+//
+// Entry: uint32 size, uint32 format, then size bytes of body
+
+#pragma once
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+class UploadSpool {
+public:
+    UploadSpool(std::string path, uint64_t maxBytes) : path_(std::move(path)), maxBytes_(maxBytes) {}
+
+    ~UploadSpool() {
+        if (file_) {
+            fclose(file_);
+            remove(path_.c_str());
+        }
+    }
+
+    UploadSpool(const UploadSpool&) = delete;
+    UploadSpool& operator=(const UploadSpool&) = delete;
+
+    bool empty() const { return readOffset_ == writeOffset_; }
+    uint64_t bytesPending() const { return writeOffset_ - readOffset_; }
+    uint64_t getDroppedCount() const { return dropped_; }
+
+    // False (and counted as dropped) when the spool is full or unwritable
+    bool append(uint32_t format, const char* body, size_t size) {
+        const uint64_t entrySize = sizeof(EntryHeader) + size;
+        if (writeOffset_ + entrySize > maxBytes_ || !open()) {
+            ++dropped_;
+            return false;
+        }
+
+        const EntryHeader header = { static_cast<uint32_t>(size), format };
+        fseeko(file_, static_cast<off_t>(writeOffset_), SEEK_SET);
+        if (fwrite(&header, sizeof(header), 1, file_) != 1 ||
+            (size > 0 && fwrite(body, size, 1, file_) != 1)) {
+            ++dropped_;
+            return false;
+        }
+        writeOffset_ += entrySize;
+        return true;
+    }
+
+    // Reads the oldest entry without consuming it
+    bool front(uint32_t& format, std::vector<char>& body) {
+        if (empty()) return false;
+
+        fflush(file_);
+        fseeko(file_, static_cast<off_t>(readOffset_), SEEK_SET);
+
+        EntryHeader header;
+        if (fread(&header, sizeof(header), 1, file_) != 1) {
+            clear();
+            return false;
+        }
+        body.resize(header.size);
+        if (header.size > 0 && fread(body.data(), header.size, 1, file_) != 1) {
+            clear();
+            return false;
+        }
+        format = header.format;
+        frontSize_ = sizeof(EntryHeader) + header.size;
+        return true;
+    }
+
+    // Consumes the entry last returned by front()
+    void popFront() {
+        readOffset_ += frontSize_;
+        frontSize_ = 0;
+        if (readOffset_ >= writeOffset_) clear();
+    }
+
+private:
+    struct EntryHeader {
+        uint32_t size;
+        uint32_t format;
+    };
+
+    bool open() {
+        if (!file_) file_ = fopen(path_.c_str(), "w+b");
+        return file_ != nullptr;
+    }
+
+    void clear() {
+        readOffset_ = writeOffset_ = 0;
+        frontSize_ = 0;
+        if (file_) {
+            fflush(file_);
+            if (ftruncate(fileno(file_), 0) != 0) {
+                // Offsets are reset either way; stale bytes are overwritten in place
+            }
+        }
+    }
+
+    std::string path_;
+    uint64_t maxBytes_;
+    FILE* file_ = nullptr;
+    uint64_t readOffset_ = 0;
+    uint64_t writeOffset_ = 0;
+    uint64_t frontSize_ = 0;
+    uint64_t dropped_ = 0;
+};
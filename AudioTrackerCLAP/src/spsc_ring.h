@@ -0,0 +1,56 @@
+// AudioTracker SPSC ring
+// Wait-free single-producer/single-consumer queue of fixed-size records.
+// The producer (audio thread) never blocks, allocates or retries: push() on a
+// full ring fails immediately and the caller decides what to count as dropped.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+template <typename T, uint32_t Capacity>
+class SpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value, "Records are copied by value");
+
+public:
+    static constexpr uint32_t kCapacity = Capacity;
+
+    // Producer only
+    bool push(const T& item) {
+        const uint32_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        buffer_[head & kMask] = item;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only
+    bool pop(T& item) {
+        const uint32_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = buffer_[tail & kMask];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate from any thread, exact from the consumer's point of view
+    uint32_t size() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+
+private:
+    static constexpr uint32_t kMask = Capacity - 1;
+
+    // Indices run freely and wrap at 2^32; head - tail is always the fill level
+    alignas(64) std::atomic<uint32_t> head_{0};
+    alignas(64) std::atomic<uint32_t> tail_{0};
+    alignas(64) T buffer_[Capacity];
+};
@@ -0,0 +1,309 @@
+// AudioTracker metrics transports
+// How MetricsStreamer gets an encoded batch to the server:
+//   HttpTransport     - libcurl POST to API_URL over one keep-alive connection
+//                       (default, and the fallback); spools to disk while the
+//                       server is down
+//   DatagramTransport - one non-blocking sendto() per batch over UDP or a Unix
+//                       datagram socket; never waits on the server
+//
+// Selected with AUDIOTRACKER_TRANSPORT:
+//   http (default) | udp://host:port | unix:/path/to/socket
+
+#pragma once
+
+#include <curl/curl.h>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "spool.h"
+#include "wire_format.h"
+
+enum class WireFormat : uint32_t {
+    Json,
+    Binary   // see wire_format.h
+};
+
+static constexpr size_t WIRE_FORMAT_COUNT = 2;
+
+static constexpr const char* DEFAULT_UDP_HOST = "127.0.0.1";
+static constexpr const char* DEFAULT_UDP_PORT = "9092";
+
+static constexpr int HTTP_RETRY_MIN_MS = 200;      // first backoff after a failure
+static constexpr int HTTP_RETRY_MAX_MS = 30000;    // backoff ceiling
+static constexpr uint64_t SPOOL_MAX_BYTES = 64ull * 1024 * 1024;
+static constexpr uint32_t SPOOL_REPLAY_PER_POLL = 64;  // bounds one tick's replay time
+
+class MetricsTransport {
+public:
+    virtual ~MetricsTransport() = default;
+
+    // Sends one encoded batch, false if it was not delivered
+    virtual bool send(const char* body, size_t size, WireFormat format) = 0;
+
+    // Largest body send() accepts; batches are sized to fit
+    virtual size_t maxPayloadSize() const = 0;
+
+    // Called once per streamer tick, whether or not there is anything to send
+    virtual void poll() {}
+
+    uint64_t getFailureCount() const { return failures_.load(std::memory_order_relaxed); }
+
+protected:
+    void countFailure() { failures_.fetch_add(1, std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> failures_{0};
+};
+
+// ============================================================================
+// HTTP - libcurl, blocking for at most the request timeout
+// ============================================================================
+//
+// The easy handle is kept for the life of the transport, so consecutive POSTs
+// (including a spool replay) go back to back over the same keep-alive
+// connection. A connection failure or 5xx starts an exponential backoff; until
+// the server answers again every batch is appended to the spool, and the spool
+// is replayed in order before any newer batch is sent.
+
+class HttpTransport : public MetricsTransport {
+public:
+    HttpTransport(const char* url, std::string spoolPath)
+        : url_(url), spool_(std::move(spoolPath), SPOOL_MAX_BYTES) {
+        curl_ = curl_easy_init();
+        if (curl_) {
+            jsonHeaders_ = curl_slist_append(jsonHeaders_, "Content-Type: application/json");
+            binaryHeaders_ = curl_slist_append(binaryHeaders_,
+                (std::string("Content-Type: ") + wire::CONTENT_TYPE).c_str());
+
+            curl_easy_setopt(curl_, CURLOPT_URL, url_.c_str());
+            curl_easy_setopt(curl_, CURLOPT_TIMEOUT_MS, 100L);
+            curl_easy_setopt(curl_, CURLOPT_CONNECTTIMEOUT_MS, 50L);
+            curl_easy_setopt(curl_, CURLOPT_TCP_KEEPALIVE, 1L);
+            curl_easy_setopt(curl_, CURLOPT_NOSIGNAL, 1L);
+        }
+    }
+
+    ~HttpTransport() override {
+        if (jsonHeaders_) curl_slist_free_all(jsonHeaders_);
+        if (binaryHeaders_) curl_slist_free_all(binaryHeaders_);
+        if (curl_) curl_easy_cleanup(curl_);
+    }
+
+    bool send(const char* body, size_t size, WireFormat format) override {
+        // Keep order: nothing new goes out while older batches wait in the spool
+        if (spool_.empty() && !backingOff() && post(body, size, format)) {
+            return true;
+        }
+        if (!spool_.append(static_cast<uint32_t>(format), body, size)) {
+            countFailure();
+        }
+        return false;
+    }
+
+    size_t maxPayloadSize() const override { return SIZE_MAX; }
+
+    // Replays spooled batches once the backoff has expired
+    void poll() override {
+        uint32_t format;
+        for (uint32_t i = 0; i < SPOOL_REPLAY_PER_POLL && !backingOff(); ++i) {
+            if (!spool_.front(format, replay_)) break;
+            if (!post(replay_.data(), replay_.size(), static_cast<WireFormat>(format))) break;
+            spool_.popFront();
+        }
+    }
+
+    uint64_t getSpooledBytes() const { return spool_.bytesPending(); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    bool backingOff() const { return backoffMs_ > 0 && Clock::now() < retryAt_; }
+
+    // One request on the persistent handle; updates the backoff state
+    bool post(const char* body, size_t size, WireFormat format) {
+        if (!curl_) return false;
+
+        curl_easy_setopt(curl_, CURLOPT_HTTPHEADER, format == WireFormat::Binary ? binaryHeaders_ : jsonHeaders_);
+        curl_easy_setopt(curl_, CURLOPT_POSTFIELDS, body);
+        curl_easy_setopt(curl_, CURLOPT_POSTFIELDSIZE, static_cast<long>(size));
+
+        long status = 0;
+        if (curl_easy_perform(curl_) == CURLE_OK) {
+            curl_easy_getinfo(curl_, CURLINFO_RESPONSE_CODE, &status);
+        }
+
+        if (status == 0 || status >= 500) {
+            // Unreachable or failing server: wait before trying again
+            backoffMs_ = backoffMs_ == 0 ? HTTP_RETRY_MIN_MS : std::min(backoffMs_ * 2, HTTP_RETRY_MAX_MS);
+            retryAt_ = Clock::now() + std::chrono::milliseconds(backoffMs_);
+            return false;
+        }
+
+        // 2xx, or a 4xx that resending would not fix
+        backoffMs_ = 0;
+        if (status >= 400) countFailure();
+        return true;
+    }
+
+    std::string url_;
+    CURL* curl_ = nullptr;
+    struct curl_slist* jsonHeaders_ = nullptr;
+    struct curl_slist* binaryHeaders_ = nullptr;
+
+    UploadSpool spool_;
+    std::vector<char> replay_;
+    int backoffMs_ = 0;
+    Clock::time_point retryAt_;
+};
+
+// ============================================================================
+// Datagram - connectionless, fire-and-forget
+// ============================================================================
+//
+// The receiver tells JSON and binary apart by the first bytes of the datagram
+// (wire::MAGIC vs '[' / '{'), so no framing is added. A full socket buffer
+// drops the batch rather than blocking the streamer thread.
+
+class DatagramTransport : public MetricsTransport {
+public:
+    static std::unique_ptr<DatagramTransport> udp(const char* host, const char* port) {
+        addrinfo hints = {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_DGRAM;
+
+        addrinfo* resolved = nullptr;
+        if (getaddrinfo(host, port, &hints, &resolved) != 0 || !resolved) {
+            return nullptr;
+        }
+
+        std::unique_ptr<DatagramTransport> transport;
+        int fd = socket(resolved->ai_family, SOCK_DGRAM, 0);
+        if (fd >= 0) {
+            // Stay under the 65507-byte IPv4 UDP limit
+            transport.reset(new DatagramTransport(fd, resolved->ai_addr, resolved->ai_addrlen, 65000));
+        }
+        freeaddrinfo(resolved);
+        return transport;
+    }
+
+    static std::unique_ptr<DatagramTransport> unixSocket(const char* path) {
+        sockaddr_un addr = {};
+        if (strlen(path) >= sizeof(addr.sun_path)) {
+            return nullptr;
+        }
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+        int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+        if (fd < 0) {
+            return nullptr;
+        }
+
+#if defined(__APPLE__)
+        // net.local.dgram.maxdgram defaults to 2 KiB on macOS
+        size_t maxPayload = 2048;
+#else
+        size_t maxPayload = 65000;
+#endif
+        int sendBuffer = 256 * 1024;
+        setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sendBuffer, sizeof(sendBuffer));
+
+        return std::unique_ptr<DatagramTransport>(new DatagramTransport(
+            fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr), maxPayload));
+    }
+
+    ~DatagramTransport() override {
+        if (fd_ >= 0) close(fd_);
+    }
+
+    bool send(const char* body, size_t size, WireFormat /*format*/) override {
+        if (size > maxPayload_) {
+            countFailure();
+            return false;
+        }
+
+        int flags = 0;
+#if defined(MSG_NOSIGNAL)
+        flags |= MSG_NOSIGNAL;
+#endif
+        ssize_t sent = sendto(fd_, body, size, flags,
+                              reinterpret_cast<const sockaddr*>(&address_), addressLength_);
+        if (sent != static_cast<ssize_t>(size)) {
+            // EAGAIN (buffer full), ECONNREFUSED/ENOENT (no receiver): drop, never wait
+            countFailure();
+            return false;
+        }
+        return true;
+    }
+
+    size_t maxPayloadSize() const override { return maxPayload_; }
+
+private:
+    DatagramTransport(int fd, const sockaddr* address, socklen_t length, size_t maxPayload)
+        : fd_(fd), addressLength_(length), maxPayload_(maxPayload) {
+        memcpy(&address_, address, length);
+        fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL, 0) | O_NONBLOCK);
+#if defined(SO_NOSIGPIPE)
+        int on = 1;
+        setsockopt(fd_, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+    }
+
+    int fd_;
+    sockaddr_storage address_ = {};
+    socklen_t addressLength_;
+    size_t maxPayload_;
+};
+
+// $AUDIOTRACKER_SPOOL_DIR, else $TMPDIR, else /tmp; tag keeps processes apart
+static std::string spoolPath(uint32_t tag) {
+    const char* dir = getenv("AUDIOTRACKER_SPOOL_DIR");
+    if (!dir || !*dir) dir = getenv("TMPDIR");
+    if (!dir || !*dir) dir = "/tmp";
+
+    std::string path(dir);
+    if (path.back() != '/') path += '/';
+    return path + "audiotracker-" + std::to_string(tag) + ".spool";
+}
+
+// Parses AUDIOTRACKER_TRANSPORT, falling back to HTTP when unset or unusable
+static std::unique_ptr<MetricsTransport> createTransport(const char* spec, const char* httpUrl, uint32_t spoolTag) {
+    if (spec && strncmp(spec, "udp://", 6) == 0) {
+        std::string hostPort(spec + 6);
+        std::string host = DEFAULT_UDP_HOST;
+        std::string port = DEFAULT_UDP_PORT;
+
+        size_t colon = hostPort.rfind(':');
+        if (colon != std::string::npos) {
+            if (colon > 0) host = hostPort.substr(0, colon);
+            port = hostPort.substr(colon + 1);
+        } else if (!hostPort.empty()) {
+            host = hostPort;
+        }
+
+        if (auto transport = DatagramTransport::udp(host.c_str(), port.c_str())) {
+            return transport;
+        }
+    } else if (spec && strncmp(spec, "unix:", 5) == 0) {
+        if (auto transport = DatagramTransport::unixSocket(spec + 5)) {
+            return transport;
+        }
+    }
+    return std::unique_ptr<MetricsTransport>(new HttpTransport(httpUrl, spoolPath(spoolTag)));
+}
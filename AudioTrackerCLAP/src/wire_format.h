@@ -0,0 +1,109 @@
+// AudioTracker binary wire format
+// Compact alternative to the JSON payload for high frame rates. All values are
+// little-endian and tightly packed.
+//
+// Packet (version 1):
+//   PacketHeader                        24 bytes
+//   recordCount x Record                recordSize bytes each
+//
+// Record:
+//   RecordHeader                        32 bytes
+//   fieldCount x float32                in METRIC_FIELDS order
+//
+// Decoders must use headerSize/recordSize from the packet rather than the
+// sizes compiled in here, so fields can be appended without a version bump.
+// The same layout is served by the server at GET /api/audio/schema.
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "wire_format.h writes native structs and assumes a little-endian host"
+#endif
+
+namespace wire {
+
+static constexpr uint32_t MAGIC = 0x464D5441;  // "ATMF"
+static constexpr uint16_t VERSION = 1;
+static constexpr const char* CONTENT_TYPE = "application/x-audiotracker-metrics";
+
+// Float32 feature fields carried by every record, in wire order
+static constexpr const char* METRIC_FIELDS[] = { "f0", "centroid", "rms", "flux", "onset" };
+static constexpr uint16_t FIELD_COUNT = sizeof(METRIC_FIELDS) / sizeof(METRIC_FIELDS[0]);
+
+#pragma pack(push, 1)
+struct PacketHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;
+    uint16_t recordSize;
+    uint16_t fieldCount;
+    uint32_t recordCount;
+    int64_t localTimeMs;   // sender wall clock when the packet was built
+};
+
+struct RecordHeader {
+    uint32_t instanceId;
+    uint32_t channel;      // input channel, 0 for the downmix (zero before channels existed)
+    uint64_t sequence;
+    uint64_t samplePosition;
+    double playheadSeconds;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(PacketHeader) == 24, "PacketHeader layout");
+static_assert(sizeof(RecordHeader) == 32, "RecordHeader layout");
+
+static constexpr uint16_t RECORD_SIZE = sizeof(RecordHeader) + FIELD_COUNT * sizeof(float);
+
+// Encodes into a buffer sized once for a maximum record count
+class PacketWriter {
+public:
+    explicit PacketWriter(uint32_t maxRecords)
+        : buffer_(sizeof(PacketHeader) + static_cast<size_t>(maxRecords) * RECORD_SIZE),
+          maxRecords_(maxRecords) {}
+
+    uint32_t maxRecords() const { return maxRecords_; }
+
+    void begin(int64_t localTimeMs) {
+        header_.magic = MAGIC;
+        header_.version = VERSION;
+        header_.headerSize = sizeof(PacketHeader);
+        header_.recordSize = RECORD_SIZE;
+        header_.fieldCount = FIELD_COUNT;
+        header_.recordCount = 0;
+        header_.localTimeMs = localTimeMs;
+        size_ = sizeof(PacketHeader);
+    }
+
+    // fields must hold FIELD_COUNT values; returns false once the packet is full
+    bool add(const RecordHeader& record, const float* fields) {
+        if (header_.recordCount >= maxRecords_) return false;
+
+        uint8_t* out = buffer_.data() + size_;
+        memcpy(out, &record, sizeof(RecordHeader));
+        memcpy(out + sizeof(RecordHeader), fields, FIELD_COUNT * sizeof(float));
+        size_ += RECORD_SIZE;
+        ++header_.recordCount;
+        return true;
+    }
+
+    // Finalizes the header, returns the encoded packet
+    const uint8_t* finish() {
+        memcpy(buffer_.data(), &header_, sizeof(PacketHeader));
+        return buffer_.data();
+    }
+
+    size_t size() const { return size_; }
+
+private:
+    std::vector<uint8_t> buffer_;
+    uint32_t maxRecords_;
+    PacketHeader header_ = {};
+    size_t size_ = 0;
+};
+
+} // namespace wire
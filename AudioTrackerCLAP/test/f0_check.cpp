@@ -0,0 +1,86 @@
+// F0 estimator check: steady sines and harmonic tones from 80 to 600 Hz at
+// every analyzer frame size and both common sample rates, down to the
+// analyzer's MIN_F0_BINS floor. Fails when any estimate is off by more than a
+// few percent, which catches octave and subharmonic errors as well as a bad
+// peak refinement.
+
+#include "../src/plugin.cpp"
+
+#include <cstdio>
+
+namespace {
+
+constexpr float kTolerance = 0.03f;  // relative
+
+
+// Steady tone with the given partial amplitudes, long enough for two frames
+std::vector<float> tone(float f0, float sampleRate, const std::vector<float>& partials, uint32_t count) {
+    std::vector<float> samples(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        double sum = 0.0;
+        for (size_t h = 0; h < partials.size(); ++h) {
+            sum += partials[h] * sin(6.283185307179586 * f0 * (h + 1) * i / sampleRate);
+        }
+        samples[i] = static_cast<float>(0.5 * sum);
+    }
+    return samples;
+}
+
+// F0 of the last frame completed by the signal
+float estimate(AudioAnalyzer& analyzer, FrameScratch& scratch, const std::vector<float>& signal) {
+    analyzer.resetBuffer();
+    float f0 = 0.0f;
+    for (uint32_t offset = 0; offset < signal.size(); offset += DEFAULT_MAX_BLOCK_SIZE) {
+        const float* channels[] = { signal.data() };
+        const uint32_t count = std::min<uint32_t>(DEFAULT_MAX_BLOCK_SIZE, static_cast<uint32_t>(signal.size()) - offset);
+        const uint32_t frames = analyzer.addSamples(channels, offset, count);
+        for (uint32_t frame = 0; frame < frames; ++frame) {
+            analyzer.analyzeFrame(frame, 0, scratch);
+            f0 = analyzer.getFrame(frame).channels[0].f0;
+        }
+    }
+    return f0;
+}
+
+} // namespace
+
+int main() {
+    const std::vector<std::vector<float>> timbres = {
+        { 1.0f },                      // sine
+        { 1.0f, 0.5f, 0.33f, 0.25f },  // sawtooth-like
+        { 0.3f, 1.0f, 0.6f, 0.3f },    // weak fundamental
+    };
+
+    int failures = 0;
+    int cases = 0;
+    for (uint32_t frameSize : { 1024u, 2048u, 4096u, 8192u }) {
+        for (float sampleRate : { 44100.0f, 48000.0f }) {
+            std::unique_ptr<AudioAnalyzer> analyzer = createAnalyzer(frameSize);
+            analyzer->setSampleRate(sampleRate);
+            analyzer->setF0Range(DEFAULT_MIN_F0_HZ, DEFAULT_MAX_F0_HZ);
+            std::unique_ptr<FrameScratch> scratch = analyzer->createScratch();
+
+            float worst = 0.0f;
+            const float lowest = std::max(80.0f, MIN_F0_BINS * sampleRate / frameSize);
+            // Quarter-tone steps, so bin-centred and bin-edge cases both occur
+            for (float f0 = lowest; f0 <= 600.0f; f0 *= 1.0293022f) {
+                for (const std::vector<float>& partials : timbres) {
+                    const float estimated = estimate(*analyzer, *scratch, tone(f0, sampleRate, partials, 2 * frameSize));
+                    const float error = std::fabs(estimated - f0) / f0;
+                    worst = std::max(worst, error);
+                    ++cases;
+                    if (!(error <= kTolerance)) {
+                        ++failures;
+                        printf("FAILED N=%u %.0f Hz: %.1f Hz tone (%zu partials) estimated as %.1f Hz\n", frameSize,
+                               sampleRate, f0, partials.size(), estimated);
+                    }
+                }
+            }
+            printf("N=%-5u %5.0f Hz  from %5.1f Hz  worst error %5.2f%%\n", frameSize, sampleRate, lowest,
+                   100.0f * worst);
+        }
+    }
+
+    printf("%d of %d estimates outside %.0f%%\n", failures, cases, 100.0f * kTolerance);
+    return failures == 0 ? 0 : 1;
+}
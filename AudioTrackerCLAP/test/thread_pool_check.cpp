@@ -0,0 +1,197 @@
+// Thread pool check: drives the plugin through its CLAP entry point once with
+// a host that offers clap.thread-pool, running every requested job on a
+// thread of its own, and once with a host that offers none. Fails unless the
+// pool is asked to run every block that has more than one analysis task, and
+// the records come out identical to the serial run.
+
+#include "../src/plugin.cpp"
+
+#include <cstdio>
+
+namespace {
+
+constexpr double kSampleRate = 44100.0;
+constexpr double kSeconds = 2.0;
+
+// The plugin the pool host runs jobs for, and what it was asked to do
+const clap_plugin_t* gPlugin = nullptr;
+uint32_t gRequests = 0;
+uint32_t gJobs = 0;
+
+bool requestExec(const clap_host_t* /*host*/, uint32_t jobs) {
+    const auto* pool = static_cast<const clap_plugin_thread_pool_t*>(
+        gPlugin->get_extension(gPlugin, CLAP_EXT_THREAD_POOL));
+    std::vector<std::thread> threads;
+    for (uint32_t job = 0; job < jobs; ++job) {
+        threads.emplace_back([pool, job] { pool->exec(gPlugin, job); });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    ++gRequests;
+    gJobs += jobs;
+    return true;
+}
+
+const clap_host_thread_pool_t hostThreadPool = { requestExec };
+
+const void* poolHostExtension(const clap_host_t* /*host*/, const char* id) {
+    return strcmp(id, CLAP_EXT_THREAD_POOL) == 0 ? &hostThreadPool : nullptr;
+}
+
+const void* plainHostExtension(const clap_host_t* /*host*/, const char* /*id*/) {
+    return nullptr;
+}
+
+struct Case {
+    const char* name;
+    uint32_t portConfig;  // index into portLayouts
+    bool split;
+    bool multiResolution;
+    uint32_t blockSize;
+};
+
+struct Run {
+    std::vector<FrameResult> records;
+    uint32_t channels = 0;
+    uint32_t parallelBlocks = 0;  // blocks with more than one job's worth of tasks
+    uint32_t parallelJobs = 0;    // the jobs those blocks split into
+};
+
+// A different tone per channel, every other channel silent for part of each
+// second, so audible and silent tasks mix within a block
+float sample(uint32_t channel, uint64_t position) {
+    const double t = position / kSampleRate;
+    if (channel % 2 == 1 && fmod(t, 1.0) > 0.6) return 0.0f;
+    return static_cast<float>(0.4 * sin(6.283185307179586 * 110.0 * (channel + 2) * t));
+}
+
+Run run(const Case& test, bool withPool) {
+    clap_host_t host = {};
+    host.clap_version = CLAP_VERSION;
+    host.get_extension = withPool ? poolHostExtension : plainHostExtension;
+    host.request_restart = [](const clap_host_t*) {};
+    host.request_process = [](const clap_host_t*) {};
+    host.request_callback = [](const clap_host_t*) {};
+
+    const auto* factory = static_cast<const clap_plugin_factory_t*>(clap_entry.get_factory(CLAP_PLUGIN_FACTORY_ID));
+    const clap_plugin_t* plugin = factory->create_plugin(factory, &host, pluginDescriptor.id);
+    gPlugin = plugin;
+    gRequests = 0;
+    gJobs = 0;
+
+    auto* state = static_cast<PluginState*>(plugin->plugin_data);
+    plugin->init(plugin);
+    audioPortsConfigExtension.select(plugin, test.portConfig);
+    state->setParam(PARAM_CHANNEL_MODE, test.split ? 1.0 : 0.0);
+    state->setParam(PARAM_MULTI_RESOLUTION, test.multiResolution ? 1.0 : 0.0);
+    plugin->activate(plugin, kSampleRate, 1, test.blockSize);
+    plugin->start_processing(plugin);
+
+    const uint32_t portChannels = portLayouts[test.portConfig].channels;
+    std::vector<std::vector<float>> buffers(portChannels, std::vector<float>(test.blockSize));
+    std::vector<float*> pointers;
+    for (std::vector<float>& buffer : buffers) pointers.push_back(buffer.data());
+
+    clap_audio_buffer_t audio = {};
+    audio.data32 = pointers.data();
+    audio.channel_count = portChannels;
+
+    clap_process_t process = {};
+    process.frames_count = test.blockSize;
+    process.audio_inputs = &audio;
+    process.audio_outputs = &audio;
+    process.audio_inputs_count = 1;
+    process.audio_outputs_count = 1;
+
+    Run result;
+    result.channels = state->analysisChannels();
+    uint64_t position = 0;
+    while (position < kSeconds * kSampleRate) {
+        for (uint32_t c = 0; c < portChannels; ++c) {
+            for (uint32_t i = 0; i < test.blockSize; ++i) buffers[c][i] = sample(c, position + i);
+        }
+        plugin->process(plugin, &process);
+        position += test.blockSize;
+
+        // One chunk per block, as blocks never exceed the activated size; a
+        // task per channel of every long frame it completed, plus one per
+        // channel for its short frames
+        const AudioAnalyzer& analyzer = *state->engine.analyzer;
+        const uint32_t transientTasks = test.multiResolution && analyzer.getRecordCount() > 0 ? 1 : 0;
+        const uint32_t tasks = (analyzer.getFrameCount() + transientTasks) * result.channels;
+        const uint32_t jobs = std::min(tasks, state->maxJobs);
+        if (jobs > 1) {
+            ++result.parallelBlocks;
+            result.parallelJobs += jobs;
+        }
+
+        for (uint32_t r = 0; r < analyzer.getRecordCount(); ++r) {
+            result.records.push_back(analyzer.getRecord(r));
+        }
+    }
+
+    plugin->stop_processing(plugin);
+    plugin->deactivate(plugin);
+    plugin->destroy(plugin);
+    gPlugin = nullptr;
+
+    if (withPool && (gRequests != result.parallelBlocks || gJobs != result.parallelJobs)) {
+        printf("FAILED %s: %u pool requests (%u jobs) for %u blocks with %u jobs\n", test.name, gRequests, gJobs,
+               result.parallelBlocks, result.parallelJobs);
+        result.records.clear();
+    }
+    return result;
+}
+
+bool sameRecords(const Run& pooled, const Run& serial) {
+    if (pooled.records.size() != serial.records.size() || pooled.records.empty()) return false;
+    for (size_t r = 0; r < pooled.records.size(); ++r) {
+        const FrameResult& a = pooled.records[r];
+        const FrameResult& b = serial.records[r];
+        if (a.samplePosition != b.samplePosition) return false;
+        for (uint32_t c = 0; c < pooled.channels; ++c) {
+            const ChannelMetrics& x = a.channels[c];
+            const ChannelMetrics& y = b.channels[c];
+            if (x.f0 != y.f0 || x.centroid != y.centroid || x.rms != y.rms || x.flux != y.flux ||
+                x.onset != y.onset) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main() {
+    // Keep the check's records off a locally running server, and analyze inline
+    setenv("AUDIOTRACKER_TRANSPORT", "udp://127.0.0.1:9", 1);
+    unsetenv("AUDIOTRACKER_ANALYSIS");
+    clap_entry.init("");
+
+    const Case cases[] = {
+        { "stereo split, 512-sample blocks", 1, true, false, 512 },
+        { "7.1 split, 2048-sample blocks", 3, true, false, 2048 },
+        { "stereo mix, 2048-sample blocks", 1, false, false, 2048 },
+        { "stereo split multi-res, 512-sample blocks", 1, true, true, 512 },
+        { "mono multi-res, 256-sample blocks", 0, false, true, 256 },
+    };
+
+    int failures = 0;
+    for (const Case& test : cases) {
+        const Run pooled = run(test, true);
+        const Run serial = run(test, false);
+
+        const bool fired = pooled.parallelBlocks > 0;
+        const bool same = sameRecords(pooled, serial);
+        printf("%-42s %5zu records, pool ran %3u blocks in %4u jobs\n", test.name, pooled.records.size(),
+               pooled.parallelBlocks, pooled.parallelJobs);
+        if (!fired) printf("FAILED %s: the thread pool was never used\n", test.name);
+        if (!same) printf("FAILED %s: records differ from the serial run\n", test.name);
+        failures += !fired + !same;
+    }
+
+    clap_entry.deinit();
+    return failures == 0 ? 0 : 1;
+}
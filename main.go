@@ -1,9 +1,17 @@
 package main
 
 import (
+	"bytes"
+	"encoding/binary"
 	"fmt"
+	"io"
 	"log"
+	"math"
+	"net"
 	"net/http"
+	"os"
+	"strings"
+	"sync"
 
 	"encoding/json"
 
@@ -13,18 +21,146 @@ import (
 
 // Handler --
 type Handler struct {
+	mu    sync.Mutex
 	Store []Audio
 }
 
 // Audio --
 type Audio struct {
-	F0        float64 `json:"f0"`
-	RMS       float64 `json:"rms"`
-	Centroid  float64 `json:"centroid"`
-	StartedAt string  `json:"startedAt"`
-	EndedAt   string  `json:"endedAt"`
-	LocalTime int64   `json:"localTime"`
-	BPM       string  `json:"bpm"`
+	Instance       uint32  `json:"instance"`
+	Channel        uint32  `json:"channel"`
+	Seq            uint64  `json:"seq"`
+	SamplePosition uint64  `json:"samplePosition"`
+	Dropped        uint64  `json:"dropped"`
+	F0             float64 `json:"f0"`
+	RMS            float64 `json:"rms"`
+	Centroid       float64 `json:"centroid"`
+	Flux           float64 `json:"flux"`
+	Onset          float64 `json:"onset"`
+	StartedAt      string  `json:"startedAt"`
+	EndedAt        string  `json:"endedAt"`
+	LocalTime      int64   `json:"localTime"`
+	BPM            string  `json:"bpm"`
+}
+
+// Binary wire format, mirrors AudioTrackerCLAP/src/wire_format.h
+const (
+	wireMagic            = 0x464D5441 // "ATMF"
+	wireVersion          = 1
+	wireContentType      = "application/x-audiotracker-metrics"
+	wirePacketHeaderSize = 24
+	wireRecordHeaderSize = 32
+)
+
+// wireFields -- float32 feature fields in record order
+var wireFields = []string{"f0", "centroid", "rms", "flux", "onset"}
+
+// WireField --
+type WireField struct {
+	Name   string `json:"name"`
+	Type   string `json:"type"`
+	Offset int    `json:"offset"`
+}
+
+// Schema -- descriptor for the binary wire format
+type Schema struct {
+	ContentType  string      `json:"contentType"`
+	Magic        uint32      `json:"magic"`
+	Version      int         `json:"version"`
+	ByteOrder    string      `json:"byteOrder"`
+	PacketHeader []WireField `json:"packetHeader"`
+	RecordHeader []WireField `json:"recordHeader"`
+	Fields       []WireField `json:"fields"`
+}
+
+// NewSchema --
+func NewSchema() *Schema {
+	schema := &Schema{
+		ContentType: wireContentType,
+		Magic:       wireMagic,
+		Version:     wireVersion,
+		ByteOrder:   "little",
+		PacketHeader: []WireField{
+			{"magic", "uint32", 0},
+			{"version", "uint16", 4},
+			{"headerSize", "uint16", 6},
+			{"recordSize", "uint16", 8},
+			{"fieldCount", "uint16", 10},
+			{"recordCount", "uint32", 12},
+			{"localTime", "int64", 16},
+		},
+		RecordHeader: []WireField{
+			{"instance", "uint32", 0},
+			{"channel", "uint32", 4},
+			{"seq", "uint64", 8},
+			{"samplePosition", "uint64", 16},
+			{"playhead", "float64", 24},
+		},
+	}
+	for idx, name := range wireFields {
+		schema.Fields = append(schema.Fields, WireField{name, "float32", wireRecordHeaderSize + 4*idx})
+	}
+	return schema
+}
+
+func formatTimestamp(seconds float64) string {
+	if seconds < 0 {
+		seconds = 0
+	}
+	millis := int64(seconds * 1000)
+	return fmt.Sprintf("%02d:%02d:%02d.%03d", millis/3600000, (millis/60000)%60, (millis/1000)%60, millis%1000)
+}
+
+// decodeBinary -- decodes one binary packet into metrics
+func decodeBinary(body []byte) ([]Audio, error) {
+	if len(body) < wirePacketHeaderSize {
+		return nil, fmt.Errorf("packet too short: %d bytes", len(body))
+	}
+	le := binary.LittleEndian
+	if magic := le.Uint32(body[0:]); magic != wireMagic {
+		return nil, fmt.Errorf("bad magic %#x", magic)
+	}
+	if version := le.Uint16(body[4:]); version != wireVersion {
+		return nil, fmt.Errorf("unsupported version %d", version)
+	}
+	headerSize := int(le.Uint16(body[6:]))
+	recordSize := int(le.Uint16(body[8:]))
+	fieldCount := int(le.Uint16(body[10:]))
+	recordCount := int(le.Uint32(body[12:]))
+	localTime := int64(le.Uint64(body[16:]))
+
+	if headerSize < wirePacketHeaderSize || recordSize < wireRecordHeaderSize+4*fieldCount ||
+		len(body) < headerSize+recordCount*recordSize {
+		return nil, fmt.Errorf("inconsistent packet sizes")
+	}
+
+	field := func(record []byte, idx int) float64 {
+		if idx >= fieldCount {
+			return 0
+		}
+		return float64(math.Float32frombits(le.Uint32(record[wireRecordHeaderSize+4*idx:])))
+	}
+
+	batch := make([]Audio, 0, recordCount)
+	for i := 0; i < recordCount; i++ {
+		record := body[headerSize+i*recordSize:]
+		playhead := formatTimestamp(math.Float64frombits(le.Uint64(record[24:])))
+		batch = append(batch, Audio{
+			Instance:       le.Uint32(record[0:]),
+			Channel:        le.Uint32(record[4:]),
+			Seq:            le.Uint64(record[8:]),
+			SamplePosition: le.Uint64(record[16:]),
+			F0:             field(record, 0),
+			Centroid:       field(record, 1),
+			RMS:            field(record, 2),
+			Flux:           field(record, 3),
+			Onset:          field(record, 4),
+			StartedAt:      playhead,
+			EndedAt:        playhead,
+			LocalTime:      localTime,
+		})
+	}
+	return batch, nil
 }
 
 // Chart --
@@ -56,21 +192,112 @@ type Dataset struct {
 	Data                      []float64 `json:"data"`
 }
 
-// Receive --
+// decodePayload -- decodes a binary packet, a JSON array or a single JSON object
+func decodePayload(body []byte, isBinary bool) ([]Audio, error) {
+	if isBinary || (len(body) >= 4 && binary.LittleEndian.Uint32(body) == wireMagic) {
+		return decodeBinary(body)
+	}
+
+	var batch []Audio
+	if trimmed := bytes.TrimSpace(body); len(trimmed) > 0 && trimmed[0] == '[' {
+		if err := json.Unmarshal(trimmed, &batch); err != nil {
+			return nil, err
+		}
+	} else {
+		var audio Audio
+		if err := json.Unmarshal(trimmed, &audio); err != nil {
+			return nil, err
+		}
+		batch = append(batch, audio)
+	}
+	return batch, nil
+}
+
+func (h *Handler) append(batch []Audio) {
+	for _, audio := range batch {
+		fmt.Printf("%v\n", audio)
+	}
+	h.mu.Lock()
+	h.Store = append(h.Store, batch...)
+	h.mu.Unlock()
+}
+
+func (h *Handler) snapshot() []Audio {
+	h.mu.Lock()
+	defer h.mu.Unlock()
+	return h.Store[:len(h.Store):len(h.Store)]
+}
+
+// Receive -- accepts a single metrics object, a JSON array of them or a binary packet
 func (h *Handler) Receive(c echo.Context) error {
-	var audio Audio
 	defer c.Request().Body.Close()
-	if err := json.NewDecoder(c.Request().Body).Decode(&audio); err != nil {
+	body, err := io.ReadAll(c.Request().Body)
+	if err != nil {
+		log.Println(err)
+		return c.NoContent(http.StatusBadRequest)
+	}
+
+	isBinary := strings.HasPrefix(c.Request().Header.Get("Content-Type"), wireContentType)
+	batch, err := decodePayload(body, isBinary)
+	if err != nil {
 		log.Println(err)
+		return c.NoContent(http.StatusBadRequest)
 	}
-	fmt.Printf("%v\n", audio)
-	h.Store = append(h.Store, audio)
+	h.append(batch)
 	return c.NoContent(http.StatusOK)
 }
 
+// Datagram endpoints for AUDIOTRACKER_TRANSPORT=udp://127.0.0.1:9092 or
+// unix:/tmp/audiotracker.sock. Each datagram is one complete batch in either format.
+const (
+	udpAddress     = "127.0.0.1:9092"
+	unixSocketPath = "/tmp/audiotracker.sock"
+	maxDatagram    = 65536
+)
+
+// ServeDatagrams -- reads batches from conn until it is closed
+func (h *Handler) ServeDatagrams(conn net.PacketConn) {
+	defer conn.Close()
+	buf := make([]byte, maxDatagram)
+	for {
+		n, _, err := conn.ReadFrom(buf)
+		if err != nil {
+			log.Println(err)
+			return
+		}
+		batch, err := decodePayload(buf[:n], false)
+		if err != nil {
+			log.Println(err)
+			continue
+		}
+		h.append(batch)
+	}
+}
+
+func listenDatagrams(h *Handler) {
+	if conn, err := net.ListenPacket("udp", udpAddress); err == nil {
+		go h.ServeDatagrams(conn)
+	} else {
+		log.Println(err)
+	}
+
+	// A socket file left by a previous run would make the bind fail
+	os.Remove(unixSocketPath)
+	if conn, err := net.ListenPacket("unixgram", unixSocketPath); err == nil {
+		go h.ServeDatagrams(conn)
+	} else {
+		log.Println(err)
+	}
+}
+
+// GetSchema --
+func (h *Handler) GetSchema(c echo.Context) error {
+	return c.JSON(http.StatusOK, NewSchema())
+}
+
 // GetStore --
 func (h *Handler) GetStore(c echo.Context) error {
-	return c.JSON(http.StatusOK, h.Store)
+	return c.JSON(http.StatusOK, h.snapshot())
 }
 
 var colors = []string{
@@ -113,7 +340,7 @@ func NewChart(props []string) *Chart {
 // GetChart --
 func (h *Handler) GetChart(c echo.Context) error {
 	chart := NewChart([]string{"f0", "rms", "centroid"})
-	for _, audio := range h.Store {
+	for _, audio := range h.snapshot() {
 		chart.Labels = append(chart.Labels, audio.StartedAt)
 		chart.Datasets[0].Data = append(chart.Datasets[0].Data, audio.F0)
 		chart.Datasets[1].Data = append(chart.Datasets[1].Data, audio.RMS)
@@ -126,9 +353,11 @@ func main() {
 	e := echo.New()
 	e.Use(middleware.CORS())
 	h := &Handler{}
+	listenDatagrams(h)
 
 	e.GET("/api/audio", h.GetStore)
 	e.POST("/api/audio", h.Receive)
 	e.GET("/api/audio/chart", h.GetChart)
+	e.GET("/api/audio/schema", h.GetSchema)
 	e.Start(":9091")
 }
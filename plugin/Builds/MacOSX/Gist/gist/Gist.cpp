@@ -23,11 +23,17 @@
 
 #include "Gist.h"
 #include <assert.h>
+#include <numeric>
 
 //=======================================================================
 template <class T>
 Gist<T>::Gist (int audioFrameSize, int fs, WindowType windowType_)
  :  fftConfigured (false),
+    featureMask (AllFeatures),
+    computedFeatures (0),
+    spectrumReady (false),
+    frameEnergyReady (false),
+    sumOfMagnitudesReady (false),
     onsetDetectionFunction (audioFrameSize),
     yin (fs),
     mfcc (audioFrameSize, fs),
@@ -57,14 +63,20 @@ void Gist<T>::setAudioFrameSize (int audioFrameSize)
     
     windowFunction = WindowFunctions<T>::createWindow (audioFrameSize, windowType);
         
-    fftReal.resize (frameSize);
-    fftImag.resize (frameSize);
+    // the input is real, so only bins 0 to N/2 are kept
+    fftReal.resize (frameSize / 2 + 1);
+    fftImag.resize (frameSize / 2 + 1);
     magnitudeSpectrum.resize (frameSize / 2);
+    powerSpectrum.resize (frameSize / 2);
     
     configureFFT();
+    clearComputedFeatures();
     
     onsetDetectionFunction.setFrameSize (frameSize);
     mfcc.setFrameSize (frameSize);
+    
+    // sets up Yin's FFT now instead of on the first pitch() call
+    yin.setAudioFrameSize (frameSize);
 }
 
 //=======================================================================
@@ -76,6 +88,14 @@ void Gist<T>::setSamplingFrequency (int fs)
     mfcc.setSamplingFrequency (samplingFrequency);
 }
 
+//=======================================================================
+template <class T>
+void Gist<T>::setPitchRange (T minFrequency, T maxFrequency)
+{
+    yin.setMinFrequency (minFrequency);
+    yin.setMaxFrequency (maxFrequency);
+}
+
 //=======================================================================
 template <class T>
 int Gist<T>::getAudioFrameSize()
@@ -90,6 +110,20 @@ int Gist<T>::getSamplingFrequency()
     return samplingFrequency;
 }
 
+//=======================================================================
+template <class T>
+void Gist<T>::setFeatureMask (int mask)
+{
+    featureMask = mask;
+}
+
+//=======================================================================
+template <class T>
+int Gist<T>::getFeatureMask()
+{
+    return featureMask;
+}
+
 //=======================================================================
 template <class T>
 void Gist<T>::processAudioFrame (const std::vector<T>& a)
@@ -99,7 +133,8 @@ void Gist<T>::processAudioFrame (const std::vector<T>& a)
     assert (a.size() == audioFrame.size());
     
     std::copy (a.begin(), a.end(), audioFrame.begin());
-    performFFT();
+    
+    clearComputedFeatures();
 }
 
 //=======================================================================
@@ -113,13 +148,14 @@ void Gist<T>::processAudioFrame (const T* frame, int numSamples)
     for (int i = 0; i < audioFrame.size(); i++)
         audioFrame[i] = frame[i];
     
-    performFFT();
+    clearComputedFeatures();
 }
 
 //=======================================================================
 template <class T>
 const std::vector<T>& Gist<T>::getMagnitudeSpectrum()
 {
+    updateSpectrum();
     return magnitudeSpectrum;
 }
 
@@ -127,105 +163,235 @@ const std::vector<T>& Gist<T>::getMagnitudeSpectrum()
 template <class T>
 T Gist<T>::rootMeanSquare()
 {
-    return coreTimeDomainFeatures.rootMeanSquare (audioFrame);
+    if (needsComputing (RootMeanSquareFeature))
+    {
+        storeFeature (RootMeanSquareFeature, coreTimeDomainFeatures.rootMeanSquare (getFrameEnergy(), frameSize));
+    }
+    
+    return storedFeature (RootMeanSquareFeature);
 }
 
 //=======================================================================
 template <class T>
 T Gist<T>::peakEnergy()
 {
-    return coreTimeDomainFeatures.peakEnergy (audioFrame);
+    if (needsComputing (PeakEnergyFeature))
+    {
+        storeFeature (PeakEnergyFeature, coreTimeDomainFeatures.peakEnergy (audioFrame));
+    }
+    
+    return storedFeature (PeakEnergyFeature);
 }
 
 //=======================================================================
 template <class T>
 T Gist<T>::zeroCrossingRate()
 {
-    return coreTimeDomainFeatures.zeroCrossingRate (audioFrame);
+    if (needsComputing (ZeroCrossingRateFeature))
+    {
+        storeFeature (ZeroCrossingRateFeature, coreTimeDomainFeatures.zeroCrossingRate (audioFrame));
+    }
+    
+    return storedFeature (ZeroCrossingRateFeature);
 }
 
 //=======================================================================
 template <class T>
 T Gist<T>::spectralCentroid()
 {
-    return coreFrequencyDomainFeatures.spectralCentroid (magnitudeSpectrum);
+    if (needsComputing (SpectralCentroidFeature))
+    {
+        updateSpectrum();
+        
+        if (usesSpectralStatistics())
+        {
+            computeSpectralStatistics();
+        }
+        else
+        {
+            storeFeature (SpectralCentroidFeature, coreFrequencyDomainFeatures.spectralCentroid (magnitudeSpectrum, getSumOfMagnitudes()));
+        }
+    }
+    
+    return storedFeature (SpectralCentroidFeature);
 }
 
 //=======================================================================
 template <class T>
 T Gist<T>::spectralCrest()
 {
-    return coreFrequencyDomainFeatures.spectralCrest (magnitudeSpectrum);
+    if (needsComputing (SpectralCrestFeature))
+    {
+        updateSpectrum();
+        
+        if (usesSpectralStatistics())
+        {
+            computeSpectralStatistics();
+        }
+        else
+        {
+            storeFeature (SpectralCrestFeature, coreFrequencyDomainFeatures.spectralCrestOfPowerSpectrum (powerSpectrum));
+        }
+    }
+    
+    return storedFeature (SpectralCrestFeature);
 }
 
 //=======================================================================
 template <class T>
 T Gist<T>::spectralFlatness()
 {
-    return coreFrequencyDomainFeatures.spectralFlatness (magnitudeSpectrum);
+    if (needsComputing (SpectralFlatnessFeature))
+    {
+        updateSpectrum();
+        
+        if (usesSpectralStatistics())
+        {
+            computeSpectralStatistics();
+        }
+        else
+        {
+            storeFeature (SpectralFlatnessFeature, coreFrequencyDomainFeatures.spectralFlatness (magnitudeSpectrum));
+        }
+    }
+    
+    return storedFeature (SpectralFlatnessFeature);
 }
 
 //=======================================================================
 template <class T>
 T Gist<T>::spectralRolloff()
 {
-    return coreFrequencyDomainFeatures.spectralRolloff (magnitudeSpectrum);
+    if (needsComputing (SpectralRolloffFeature))
+    {
+        updateSpectrum();
+        
+        if (usesSpectralStatistics())
+        {
+            computeSpectralStatistics();
+        }
+        else
+        {
+            storeFeature (SpectralRolloffFeature, coreFrequencyDomainFeatures.spectralRolloff (magnitudeSpectrum, getSumOfMagnitudes(), 0.85));
+        }
+    }
+    
+    return storedFeature (SpectralRolloffFeature);
 }
 
 //=======================================================================
 template <class T>
 T Gist<T>::spectralKurtosis()
 {
-    return coreFrequencyDomainFeatures.spectralKurtosis (magnitudeSpectrum);
+    if (needsComputing (SpectralKurtosisFeature))
+    {
+        updateSpectrum();
+        
+        if (usesSpectralStatistics())
+        {
+            computeSpectralStatistics();
+        }
+        else
+        {
+            storeFeature (SpectralKurtosisFeature, coreFrequencyDomainFeatures.spectralKurtosis (magnitudeSpectrum, getSumOfMagnitudes() / (T)magnitudeSpectrum.size()));
+        }
+    }
+    
+    return storedFeature (SpectralKurtosisFeature);
 }
 
 //=======================================================================
 template <class T>
 T Gist<T>::energyDifference()
 {
-    return onsetDetectionFunction.energyDifference (audioFrame);
+    if (needsComputing (EnergyDifferenceFeature))
+    {
+        storeFeature (EnergyDifferenceFeature, onsetDetectionFunction.energyDifference (getFrameEnergy()));
+    }
+    
+    return storedFeature (EnergyDifferenceFeature);
 }
 
 //=======================================================================
 template <class T>
 T Gist<T>::spectralDifference()
 {
-    return onsetDetectionFunction.spectralDifference (magnitudeSpectrum);
+    if (needsComputing (SpectralDifferenceFeature))
+    {
+        updateSpectrum();
+        storeFeature (SpectralDifferenceFeature, onsetDetectionFunction.spectralDifference (magnitudeSpectrum));
+    }
+    
+    return storedFeature (SpectralDifferenceFeature);
 }
 
 //=======================================================================
 template <class T>
 T Gist<T>::spectralDifferenceHWR()
 {
-    return onsetDetectionFunction.spectralDifferenceHWR (magnitudeSpectrum);
+    if (needsComputing (SpectralDifferenceHWRFeature))
+    {
+        updateSpectrum();
+        storeFeature (SpectralDifferenceHWRFeature, onsetDetectionFunction.spectralDifferenceHWR (magnitudeSpectrum));
+    }
+    
+    return storedFeature (SpectralDifferenceHWRFeature);
 }
 
 //=======================================================================
 template <class T>
 T Gist<T>::complexSpectralDifference()
 {
-    return onsetDetectionFunction.complexSpectralDifference (fftReal, fftImag);
+    if (needsComputing (ComplexSpectralDifferenceFeature))
+    {
+        updateSpectrum();
+        storeFeature (ComplexSpectralDifferenceFeature, onsetDetectionFunction.complexSpectralDifference (fftReal, fftImag));
+    }
+    
+    return storedFeature (ComplexSpectralDifferenceFeature);
 }
 
 //=======================================================================
 template <class T>
 T Gist<T>::highFrequencyContent()
 {
-    return onsetDetectionFunction.highFrequencyContent (magnitudeSpectrum);
+    if (needsComputing (HighFrequencyContentFeature))
+    {
+        updateSpectrum();
+        storeFeature (HighFrequencyContentFeature, onsetDetectionFunction.highFrequencyContent (magnitudeSpectrum));
+    }
+    
+    return storedFeature (HighFrequencyContentFeature);
 }
 
 //=======================================================================
 template <class T>
 T Gist<T>::pitch()
 {
-    return yin.pitchYin (audioFrame);
+    if (needsComputing (PitchFeature))
+    {
+        storeFeature (PitchFeature, yin.pitchYin (audioFrame));
+    }
+    
+    return storedFeature (PitchFeature);
 }
 
 //=======================================================================
 template <class T>
 const std::vector<T>& Gist<T>::getMelFrequencySpectrum()
 {
-    mfcc.calculateMelFrequencySpectrum (magnitudeSpectrum);
+    if ((featureMask & MelFrequencySpectrumFeature) == 0)
+    {
+        return noValues;
+    }
+    
+    if (needsComputing (MelFrequencySpectrumFeature))
+    {
+        updateSpectrum();
+        mfcc.calculateMelFrequencySpectrum (magnitudeSpectrum);
+        computedFeatures |= MelFrequencySpectrumFeature;
+    }
+    
     return mfcc.melSpectrum;
 }
 
@@ -233,10 +399,138 @@ const std::vector<T>& Gist<T>::getMelFrequencySpectrum()
 template <class T>
 const std::vector<T>& Gist<T>::getMelFrequencyCepstralCoefficients()
 {
-    mfcc.calculateMelFrequencyCepstralCoefficients (magnitudeSpectrum);
+    if ((featureMask & MelFrequencyCepstralCoefficientsFeature) == 0)
+    {
+        return noValues;
+    }
+    
+    if (needsComputing (MelFrequencyCepstralCoefficientsFeature))
+    {
+        updateSpectrum();
+        mfcc.calculateMelFrequencyCepstralCoefficients (magnitudeSpectrum);
+        
+        // the mel spectrum was computed on the way
+        computedFeatures |= (MelFrequencyCepstralCoefficientsFeature | (featureMask & MelFrequencySpectrumFeature));
+    }
+    
     return mfcc.MFCCs;
 }
 
+//=======================================================================
+template <class T>
+void Gist<T>::clearComputedFeatures()
+{
+    // nothing is computed for a new frame until a feature is requested
+    computedFeatures = 0;
+    spectrumReady = false;
+    frameEnergyReady = false;
+    sumOfMagnitudesReady = false;
+}
+
+//=======================================================================
+template <class T>
+bool Gist<T>::needsComputing (GistFeature feature)
+{
+    // a feature outside the feature mask is never computed, and reads as 0
+    return ((featureMask & feature) != 0) && ((computedFeatures & feature) == 0);
+}
+
+//=======================================================================
+template <class T>
+void Gist<T>::storeFeature (GistFeature feature, T value)
+{
+    // computeSpectralStatistics() produces some features that may not be selected
+    if ((featureMask & feature) == 0)
+    {
+        return;
+    }
+    
+    for (int i = 0; i < numGistFeatures; i++)
+    {
+        if (feature == (1 << i))
+        {
+            featureValues[i] = value;
+        }
+    }
+    
+    computedFeatures |= feature;
+}
+
+//=======================================================================
+template <class T>
+T Gist<T>::storedFeature (GistFeature feature)
+{
+    if ((computedFeatures & feature) == 0)
+    {
+        return 0.0;
+    }
+    
+    for (int i = 0; i < numGistFeatures; i++)
+    {
+        if (feature == (1 << i))
+        {
+            return featureValues[i];
+        }
+    }
+    
+    return 0.0;
+}
+
+//=======================================================================
+template <class T>
+bool Gist<T>::usesSpectralStatistics()
+{
+    int selected = featureMask & spectralStatisticsFeatures;
+    
+    // more than one flag set
+    return (selected & (selected - 1)) != 0;
+}
+
+//=======================================================================
+template <class T>
+void Gist<T>::computeSpectralStatistics()
+{
+    SpectralStatistics<T> statistics = coreFrequencyDomainFeatures.spectralStatistics (magnitudeSpectrum);
+    
+    storeFeature (SpectralCentroidFeature, statistics.centroid);
+    storeFeature (SpectralCrestFeature, statistics.crest);
+    storeFeature (SpectralFlatnessFeature, statistics.flatness);
+    storeFeature (SpectralRolloffFeature, statistics.rolloff);
+    storeFeature (SpectralKurtosisFeature, statistics.kurtosis);
+}
+
+//=======================================================================
+template <class T>
+T Gist<T>::getFrameEnergy()
+{
+    if (!frameEnergyReady)
+    {
+        frameEnergy = 0;
+        
+        for (int i = 0; i < frameSize; i++)
+        {
+            frameEnergy += audioFrame[i] * audioFrame[i];
+        }
+        
+        frameEnergyReady = true;
+    }
+    
+    return frameEnergy;
+}
+
+//=======================================================================
+template <class T>
+T Gist<T>::getSumOfMagnitudes()
+{
+    if (!sumOfMagnitudesReady)
+    {
+        sumOfMagnitudes = std::accumulate (magnitudeSpectrum.begin(), magnitudeSpectrum.end(), (T)0.0);
+        sumOfMagnitudesReady = true;
+    }
+    
+    return sumOfMagnitudes;
+}
+
 //=======================================================================
 template <class T>
 void Gist<T>::configureFFT()
@@ -249,23 +543,24 @@ void Gist<T>::configureFFT()
 #ifdef USE_FFTW
     // ------------------------------------------------------
     // initialise the fft time and frequency domain audio frame arrays
-    fftIn = (fftw_complex*)fftw_malloc (sizeof (fftw_complex) * frameSize);  // complex array to hold fft data
-    fftOut = (fftw_complex*)fftw_malloc (sizeof (fftw_complex) * frameSize); // complex array to hold fft data
+    fftIn = (double*)fftw_malloc (sizeof (double) * frameSize);                          // real array to hold the windowed frame
+    fftOut = (fftw_complex*)fftw_malloc (sizeof (fftw_complex) * (frameSize / 2 + 1)); // complex array to hold fft data
     
     // FFT plan initialisation
-    p = fftw_plan_dft_1d (frameSize, fftIn, fftOut, FFTW_FORWARD, FFTW_ESTIMATE);
+    p = fftw_plan_dft_r2c_1d (frameSize, fftIn, fftOut, FFTW_ESTIMATE);
 #endif /* END USE_FFTW */
     
 #ifdef USE_KISS_FFT
     // ------------------------------------------------------
     // initialise the fft time and frequency domain audio frame arrays
-    fftIn = new kiss_fft_cpx[frameSize];
-    fftOut = new kiss_fft_cpx[frameSize];
-    cfg = kiss_fft_alloc (frameSize, 0, 0, 0);
+    fftIn = new kiss_fft_scalar[frameSize];
+    fftOut = new kiss_fft_cpx[frameSize / 2 + 1];
+    cfg = kiss_fftr_alloc (frameSize, 0, 0, 0);
 #endif /* END USE_KISS_FFT */
     
 #ifdef USE_ACCELERATE_FFT
     accelerateFFT.setAudioFrameSize (frameSize);
+    fftIn.resize (frameSize);
 #endif
     
     fftConfigured = true;
@@ -300,15 +595,14 @@ void Gist<T>::performFFT()
     // copy samples from audio frame
     for (int i = 0; i < frameSize; i++)
     {
-        fftIn[i][0] = (double)(audioFrame[i] * windowFunction[i]);
-        fftIn[i][1] = (double)0.0;
+        fftIn[i] = (double)(audioFrame[i] * windowFunction[i]);
     }
     
     // perform the FFT
     fftw_execute (p);
     
     // store real and imaginary parts of FFT
-    for (int i = 0; i < frameSize; i++)
+    for (int i = 0; i <= frameSize / 2; i++)
     {
         fftReal[i] = (T)fftOut[i][0];
         fftImag[i] = (T)fftOut[i][1];
@@ -318,15 +612,14 @@ void Gist<T>::performFFT()
 #ifdef USE_KISS_FFT
     for (int i = 0; i < frameSize; i++)
     {
-        fftIn[i].r = (double)(audioFrame[i] * windowFunction[i]);
-        fftIn[i].i = 0.0;
+        fftIn[i] = (kiss_fft_scalar)(audioFrame[i] * windowFunction[i]);
     }
     
     // execute kiss fft
-    kiss_fft (cfg, fftIn, fftOut);
+    kiss_fftr (cfg, fftIn, fftOut);
     
     // store real and imaginary parts of FFT
-    for (int i = 0; i < frameSize; i++)
+    for (int i = 0; i <= frameSize / 2; i++)
     {
         fftReal[i] = (T)fftOut[i].r;
         fftImag[i] = (T)fftOut[i].i;
@@ -334,30 +627,31 @@ void Gist<T>::performFFT()
 #endif
     
 #ifdef USE_ACCELERATE_FFT
-    
-    T inputFrame[frameSize];
-    T outputReal[frameSize];
-    T outputImag[frameSize];
-    
     for (int i = 0; i < frameSize; i++)
     {
-        inputFrame[i] = audioFrame[i] * windowFunction[i];
-    }
-    
-    accelerateFFT.performFFT (inputFrame, outputReal, outputImag);
-    
-    for (int i = 0; i < frameSize; i++)
-    {
-        fftReal[i] = outputReal[i];
-        fftImag[i] = outputImag[i];
+        fftIn[i] = audioFrame[i] * windowFunction[i];
     }
     
+    // writes bins 0 to N/2 straight into fftReal and fftImag
+    accelerateFFT.performHalfSpectrumFFT (&fftIn[0], &fftReal[0], &fftImag[0]);
 #endif
     
-    // calculate the magnitude spectrum
+    // calculate the power and magnitude spectra
     for (int i = 0; i < frameSize / 2; i++)
     {
-        magnitudeSpectrum[i] = sqrt ((fftReal[i] * fftReal[i]) + (fftImag[i] * fftImag[i]));
+        powerSpectrum[i] = (fftReal[i] * fftReal[i]) + (fftImag[i] * fftImag[i]);
+        magnitudeSpectrum[i] = sqrt (powerSpectrum[i]);
+    }
+}
+
+//=======================================================================
+template <class T>
+void Gist<T>::updateSpectrum()
+{
+    if (!spectrumReady)
+    {
+        performFFT();
+        spectrumReady = true;
     }
 }
 
@@ -22,6 +22,7 @@
 //=======================================================================
 
 #include "CoreFrequencyDomainFeatures.h"
+#include <algorithm>
 
 //===========================================================
 template <class T>
@@ -62,6 +63,27 @@ T CoreFrequencyDomainFeatures<T>::spectralCentroid (const std::vector<T>& magnit
     }
 }
 
+//===========================================================
+template <class T>
+T CoreFrequencyDomainFeatures<T>::spectralCentroid (const std::vector<T>& magnitudeSpectrum, T sumOfMagnitudes)
+{
+    // if the buffer was all zeros, to be safe just return zero
+    if (sumOfMagnitudes <= 0)
+    {
+        return 0.0;
+    }
+
+    // to hold sum of weighted amplitudes
+    T sumWeightedAmplitudes = 0.0;
+
+    for (int i = 0; i < magnitudeSpectrum.size(); i++)
+    {
+        sumWeightedAmplitudes += magnitudeSpectrum[i] * i;
+    }
+
+    return sumWeightedAmplitudes / sumOfMagnitudes;
+}
+
 //===========================================================
 template <class T>
 T CoreFrequencyDomainFeatures<T>::spectralFlatness (const std::vector<T>& magnitudeSpectrum)
@@ -132,12 +154,48 @@ T CoreFrequencyDomainFeatures<T>::spectralCrest (const std::vector<T>& magnitude
     return spectralCrest;
 }
 
+//===========================================================
+template <class T>
+T CoreFrequencyDomainFeatures<T>::spectralCrestOfPowerSpectrum (const std::vector<T>& powerSpectrum)
+{
+    T sumVal = 0.0;
+    T maxVal = 0.0;
+
+    for (int i = 0; i < powerSpectrum.size(); i++)
+    {
+        sumVal += powerSpectrum[i];
+
+        if (powerSpectrum[i] > maxVal)
+        {
+            maxVal = powerSpectrum[i];
+        }
+    }
+
+    if (sumVal > 0)
+    {
+        return maxVal / (sumVal / (T)powerSpectrum.size());
+    }
+    else
+    {
+        // this is a ratio so we return 1.0 if the buffer is just zeros
+        return 1.0;
+    }
+}
+
 //===========================================================
 template <class T>
 T CoreFrequencyDomainFeatures<T>::spectralRolloff (const std::vector<T>& magnitudeSpectrum, T percentile)
 {
-    T sumOfMagnitudeSpectrum = std::accumulate (magnitudeSpectrum.begin(), magnitudeSpectrum.end(), 0);
-    T threshold = sumOfMagnitudeSpectrum * percentile;
+    T sumOfMagnitudeSpectrum = std::accumulate (magnitudeSpectrum.begin(), magnitudeSpectrum.end(), (T)0.0);
+    
+    return spectralRolloff (magnitudeSpectrum, sumOfMagnitudeSpectrum, percentile);
+}
+
+//===========================================================
+template <class T>
+T CoreFrequencyDomainFeatures<T>::spectralRolloff (const std::vector<T>& magnitudeSpectrum, T sumOfMagnitudes, T percentile)
+{
+    T threshold = sumOfMagnitudes * percentile;
     
     T cumulativeSum = 0;
     int index = 0;
@@ -164,10 +222,15 @@ T CoreFrequencyDomainFeatures<T>::spectralKurtosis (const std::vector<T>& magnit
 {
     // https://en.wikipedia.org/wiki/Kurtosis#Sample_kurtosis
     
-    T sumOfMagnitudeSpectrum = std::accumulate (magnitudeSpectrum.begin(), magnitudeSpectrum.end(), 0);
-    
-    T mean = sumOfMagnitudeSpectrum / (T)magnitudeSpectrum.size();
+    T sumOfMagnitudeSpectrum = std::accumulate (magnitudeSpectrum.begin(), magnitudeSpectrum.end(), (T)0.0);
     
+    return spectralKurtosis (magnitudeSpectrum, sumOfMagnitudeSpectrum / (T)magnitudeSpectrum.size());
+}
+
+//===========================================================
+template <class T>
+T CoreFrequencyDomainFeatures<T>::spectralKurtosis (const std::vector<T>& magnitudeSpectrum, T mean)
+{
     T moment2 = 0;
     T moment4 = 0;
     
@@ -193,6 +256,184 @@ T CoreFrequencyDomainFeatures<T>::spectralKurtosis (const std::vector<T>& magnit
     }
 }
 
+//===========================================================
+template <class T>
+SpectralStatistics<T> CoreFrequencyDomainFeatures<T>::spectralStatistics (const std::vector<T>& magnitudeSpectrum, T rolloffPercentile)
+{
+    const T* magnitudes = magnitudeSpectrum.data();
+    const int numBins = (int)magnitudeSpectrum.size();
+    const int numBlockBins = numBins - (numBins % numLanes);
+    
+    SpectralStatistics<T> statistics;
+    
+    if (numBins == 0)
+    {
+        statistics.centroid = 0.0;
+        statistics.crest = 1.0;
+        statistics.flatness = 0.0;
+        statistics.rolloff = 0.0;
+        statistics.kurtosis = -3.;
+        return statistics;
+    }
+    
+    //===========================================================
+    // first pass: the sums for the centroid, crest and flatness, and the
+    // sum of magnitudes needed for the mean and the rolloff threshold
+    double sum[numLanes] = {};
+    double weightedSum[numLanes] = {};
+    double sumOfSquares[numLanes] = {};
+    double maxMagnitude[numLanes] = {};
+    
+    // the flatness needs the sum of log (1 + magnitude); multiplying a few
+    // (1 + magnitude) terms together first takes one log per binsPerLogarithm bins
+    double logProduct[numLanes];
+    double logSum = 0.0;
+    int numProductTerms = 0;
+    
+    for (int j = 0; j < numLanes; j++)
+    {
+        logProduct[j] = 1.0;
+    }
+    
+    for (int i = 0; i < numBlockBins; i += numLanes)
+    {
+        for (int j = 0; j < numLanes; j++)
+        {
+            double v = (double)magnitudes[i + j];
+            
+            sum[j] += v;
+            weightedSum[j] += v * (double)(i + j);
+            sumOfSquares[j] += v * v;
+            maxMagnitude[j] = std::max (maxMagnitude[j], v);
+            logProduct[j] *= 1.0 + v;
+        }
+        
+        if (++numProductTerms == binsPerLogarithm)
+        {
+            for (int j = 0; j < numLanes; j++)
+            {
+                logSum += log (logProduct[j]);
+                logProduct[j] = 1.0;
+            }
+            
+            numProductTerms = 0;
+        }
+    }
+    
+    for (int j = 0; j < numLanes; j++)
+    {
+        logSum += log (logProduct[j]);
+    }
+    
+    for (int i = numBlockBins; i < numBins; i++)
+    {
+        double v = (double)magnitudes[i];
+        
+        sum[0] += v;
+        weightedSum[0] += v * (double)i;
+        sumOfSquares[0] += v * v;
+        maxMagnitude[0] = std::max (maxMagnitude[0], v);
+        logSum += log (1.0 + v);
+    }
+    
+    double totalSum = 0.0;
+    double totalWeightedSum = 0.0;
+    double totalSumOfSquares = 0.0;
+    double peakMagnitude = 0.0;
+    
+    for (int j = 0; j < numLanes; j++)
+    {
+        totalSum += sum[j];
+        totalWeightedSum += weightedSum[j];
+        totalSumOfSquares += sumOfSquares[j];
+        peakMagnitude = std::max (peakMagnitude, maxMagnitude[j]);
+    }
+    
+    double N = (double)numBins;
+    
+    statistics.centroid = totalSum > 0 ? (T)(totalWeightedSum / totalSum) : 0.0;
+    
+    // this is a ratio so it is 1.0 if the buffer is just zeros
+    statistics.crest = totalSumOfSquares > 0 ? (T)((peakMagnitude * peakMagnitude) / (totalSumOfSquares / N)) : 1.0;
+    
+    // the mean of (1 + magnitude) is always positive
+    statistics.flatness = (T)(exp (logSum / N) / ((totalSum + N) / N));
+    
+    //===========================================================
+    // second pass: the central moments for the kurtosis, and the rolloff
+    // bin, found by checking a block's total before stepping through its bins
+    double mean = totalSum / N;
+    double threshold = totalSum * (double)rolloffPercentile;
+    double moment2[numLanes] = {};
+    double moment4[numLanes] = {};
+    double cumulativeSum = 0.0;
+    int rolloffIndex = -1;
+    
+    for (int i = 0; i < numBlockBins; i += numLanes)
+    {
+        double blockSum = 0.0;
+        
+        for (int j = 0; j < numLanes; j++)
+        {
+            double difference = (double)magnitudes[i + j] - mean;
+            double squaredDifference = difference * difference;
+            
+            moment2[j] += squaredDifference;
+            moment4[j] += squaredDifference * squaredDifference;
+            blockSum += (double)magnitudes[i + j];
+        }
+        
+        if (rolloffIndex < 0 && cumulativeSum + blockSum > threshold)
+        {
+            for (int j = 0; j < numLanes && rolloffIndex < 0; j++)
+            {
+                cumulativeSum += (double)magnitudes[i + j];
+                
+                if (cumulativeSum > threshold)
+                {
+                    rolloffIndex = i + j;
+                }
+            }
+        }
+        else
+        {
+            cumulativeSum += blockSum;
+        }
+    }
+    
+    for (int i = numBlockBins; i < numBins; i++)
+    {
+        double difference = (double)magnitudes[i] - mean;
+        double squaredDifference = difference * difference;
+        
+        moment2[0] += squaredDifference;
+        moment4[0] += squaredDifference * squaredDifference;
+        cumulativeSum += (double)magnitudes[i];
+        
+        if (rolloffIndex < 0 && cumulativeSum > threshold)
+        {
+            rolloffIndex = i;
+        }
+    }
+    
+    double totalMoment2 = 0.0;
+    double totalMoment4 = 0.0;
+    
+    for (int j = 0; j < numLanes; j++)
+    {
+        totalMoment2 += moment2[j];
+        totalMoment4 += moment4[j];
+    }
+    
+    totalMoment2 = totalMoment2 / N;
+    totalMoment4 = totalMoment4 / N;
+    
+    statistics.rolloff = ((T)std::max (rolloffIndex, 0)) / ((T)numBins);
+    statistics.kurtosis = totalMoment2 == 0 ? -3. : (T)((totalMoment4 / (totalMoment2 * totalMoment2)) - 3.);
+    
+    return statistics;
+}
+
 //===========================================================
 template class CoreFrequencyDomainFeatures<float>;
 template class CoreFrequencyDomainFeatures<double>;
@@ -43,7 +43,14 @@ T CoreTimeDomainFeatures<T>::rootMeanSquare (const std::vector<T>& buffer)
     }
 
     // return the square root of the mean of squared samples
-    return sqrt (sum / ((T)buffer.size()));
+    return rootMeanSquare (sum, (int)buffer.size());
+}
+
+//===========================================================
+template <class T>
+T CoreTimeDomainFeatures<T>::rootMeanSquare (T sumOfSquares, int numSamples)
+{
+    return sqrt (sumOfSquares / ((T)numSamples));
 }
 
 //===========================================================
@@ -24,6 +24,7 @@
 #include "MFCC.h"
 #include <cfloat>
 #include <assert.h>
+#include <algorithm>
 
 //==================================================================
 template <class T>
@@ -67,9 +68,9 @@ void MFCC<T>::calculateMelFrequencyCepstralCoefficients (const std::vector<T>& m
     calculateMelFrequencySpectrum (magnitudeSpectrum);
     
     for (int i = 0; i < melSpectrum.size(); i++)
-        MFCCs[i] = log (melSpectrum[i] + (T)FLT_MIN);
+        logMelSpectrum[i] = log (melSpectrum[i] + (T)FLT_MIN);
 
-    discreteCosineTransform (MFCCs, MFCCs.size());
+    discreteCosineTransform (logMelSpectrum, MFCCs);
 }
 
 //==================================================================
@@ -78,14 +79,33 @@ void MFCC<T>::calculateMelFrequencySpectrum (const std::vector<T>& magnitudeSpec
 {
     for (int i = 0; i < numCoefficents; i++)
     {
-        double coeff = 0;
+        // each filter only covers the bins in its span
+        const T* weights = filterWeights[i].data();
+        const T* magnitudes = magnitudeSpectrum.data() + filterStart[i];
+        const int numWeights = (int)filterWeights[i].size();
+        const int numBlockWeights = numWeights - (numWeights % numLanes);
         
-        for (int j = 0; j < magnitudeSpectrum.size(); j++)
+        double coeff[numLanes] = {};
+        
+        for (int j = 0; j < numBlockWeights; j += numLanes)
+        {
+            for (int k = 0; k < numLanes; k++)
+            {
+                coeff[k] += (magnitudes[j + k] * magnitudes[j + k]) * weights[j + k];
+            }
+        }
+        
+        for (int j = numBlockWeights; j < numWeights; j++)
+        {
+            coeff[0] += (magnitudes[j] * magnitudes[j]) * weights[j];
+        }
+        
+        for (int k = 1; k < numLanes; k++)
         {
-            coeff += (T)((magnitudeSpectrum[j] * magnitudeSpectrum[j]) * filterBank[i][j]);
+            coeff[0] += coeff[k];
         }
         
-        melSpectrum[i] = coeff;
+        melSpectrum[i] = (T)coeff[0];
     }
 }
 
@@ -98,39 +118,63 @@ void MFCC<T>::initialise()
     maxFrequency = samplingFrequency / 2;
 
     melSpectrum.resize (numCoefficents);
+    logMelSpectrum.resize (numCoefficents);
     MFCCs.resize (numCoefficents);
     
     calculateMelFilterBank();
+    calculateDCTMatrix();
 }
 
 //==================================================================
 template <class T>
-void MFCC<T>::discreteCosineTransform (std::vector<T>& inputSignal, const size_t numElements)
+void MFCC<T>::discreteCosineTransform (const std::vector<T>& inputSignal, std::vector<T>& outputSignal)
 {
-    // the input signal must have the number of elements specified in the numElements variable
-    assert (inputSignal.size() == numElements);
-    
-    T signal[numElements]; // copy to work on
+    // the signals must have one element per coefficient
+    assert (inputSignal.size() == numCoefficents && outputSignal.size() == numCoefficents);
     
-    for (int i = 0; i < numElements; i++)
-        signal[i] = inputSignal[i];
+    const int numBlockElements = numCoefficents - (numCoefficents % numLanes);
     
-    T N = (T)numElements;
-    T piOverN = M_PI / N;
-
-    for (int k = 0; k < numElements; k++)
+    for (int k = 0; k < numCoefficents; k++)
     {
-        T sum = 0;
-        T kVal = (T)k;
-
-        for (int n = 0; n < numElements; n++)
+        const T* row = dctMatrix.data() + (k * numCoefficents);
+        T sum[numLanes] = {};
+        
+        for (int n = 0; n < numBlockElements; n += numLanes)
         {
-            T tmp = piOverN * (((T)n) + 0.5) * kVal;
-
-            sum += signal[n] * cos (tmp);
+            for (int j = 0; j < numLanes; j++)
+            {
+                sum[j] += inputSignal[n + j] * row[n + j];
+            }
+        }
+        
+        for (int n = numBlockElements; n < numCoefficents; n++)
+        {
+            sum[0] += inputSignal[n] * row[n];
         }
+        
+        for (int j = 1; j < numLanes; j++)
+        {
+            sum[0] += sum[j];
+        }
+        
+        outputSignal[k] = sum[0];
+    }
+}
 
-        inputSignal[k] = (T)(2 * sum);
+//==================================================================
+template <class T>
+void MFCC<T>::calculateDCTMatrix()
+{
+    dctMatrix.resize (numCoefficents * numCoefficents);
+    
+    double piOverN = M_PI / (double)numCoefficents;
+    
+    for (int k = 0; k < numCoefficents; k++)
+    {
+        for (int n = 0; n < numCoefficents; n++)
+        {
+            dctMatrix[(k * numCoefficents) + n] = (T)(2 * cos (piOverN * (((double)n) + 0.5) * (double)k));
+        }
     }
 }
 
@@ -141,17 +185,8 @@ void MFCC<T>::calculateMelFilterBank()
     int maxMel = floor (frequencyToMel (maxFrequency));
     int minMel = floor (frequencyToMel (minFrequency));
 
-    filterBank.resize (numCoefficents);
-
-    for (int i = 0; i < numCoefficents; i++)
-    {
-        filterBank[i].resize (magnitudeSpectrumSize);
-
-        for (int j = 0; j < magnitudeSpectrumSize; j++)
-        {
-            filterBank[i][j] = 0.0;
-        }
-    }
+    filterStart.resize (numCoefficents);
+    filterWeights.resize (numCoefficents);
 
     std::vector<int> centreIndices;
 
@@ -180,16 +215,23 @@ void MFCC<T>::calculateMelFilterBank()
         T triangleRangeUp = (T)(filterCenterIndex - filterBeginIndex);
         T triangleRangeDown = (T)(filterEndIndex - filterCenterIndex);
 
+        // the triangle is zero at its first bin, so the span starts one bin later
+        int spanBegin = std::min (filterBeginIndex + 1, filterCenterIndex);
+        int spanEnd = std::min (filterEndIndex, magnitudeSpectrumSize);
+
+        filterStart[i] = spanBegin;
+        filterWeights[i].assign (std::max (spanEnd - spanBegin, 0), 0.0);
+
         // upward slope
-        for (int k = filterBeginIndex; k < filterCenterIndex; k++)
+        for (int k = spanBegin; k < filterCenterIndex && k < spanEnd; k++)
         {
-            filterBank[i][k] = ((T)(k - filterBeginIndex)) / triangleRangeUp;
+            filterWeights[i][k - spanBegin] = ((T)(k - filterBeginIndex)) / triangleRangeUp;
         }
 
         // downwards slope
-        for (int k = filterCenterIndex; k < filterEndIndex; k++)
+        for (int k = filterCenterIndex; k < spanEnd; k++)
         {
-            filterBank[i][k] = ((T)(filterEndIndex - k)) / triangleRangeDown;
+            filterWeights[i][k - spanBegin] = ((T)(filterEndIndex - k)) / triangleRangeDown;
         }
     }
 }
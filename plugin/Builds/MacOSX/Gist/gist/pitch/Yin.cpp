@@ -31,7 +31,20 @@ Yin<T>::Yin (int samplingFrequency)
         
     setMaxFrequency (1500);
     
+    maxPeriod = 0;
+    
     prevPeriodEstimate = 1.0;
+    
+    fftSize = 0;
+    
+    audioFrameSize = 0;
+}
+
+//===========================================================
+template <class T>
+Yin<T>::~Yin()
+{
+    freeFFT();
 }
 
 //===========================================================
@@ -43,6 +56,9 @@ void Yin<T>::setSamplingFrequency (int samplingFrequency)
     fs = samplingFrequency;
     
     minPeriod = ((float) fs) / ((float) oldFs) * minPeriod;
+    maxPeriod = ((float) fs) / ((float) oldFs) * maxPeriod;
+    
+    prepareFFT();
 }
 
 //===========================================================
@@ -63,6 +79,32 @@ void Yin<T>::setMaxFrequency (T maxFreq)
     minPeriod = (int) ceil (minPeriodFloating);
 }
 
+//===========================================================
+template <class T>
+void Yin<T>::setMinFrequency (T minFreq)
+{
+    if (minFreq <= 0)
+    {
+        maxPeriod = 0;
+    }
+    else
+    {
+        maxPeriod = (int) ceil (((T) fs) / minFreq);
+    }
+    
+    // the number of lags, and with it the FFT size, may have changed
+    prepareFFT();
+}
+
+//===========================================================
+template <class T>
+void Yin<T>::setAudioFrameSize (unsigned long frameSize)
+{
+    audioFrameSize = frameSize;
+    
+    prepareFFT();
+}
+
 //===========================================================
 template <class T>
 T Yin<T>::pitchYin (const std::vector<T>& frame)
@@ -113,24 +155,15 @@ void Yin<T>::cumulativeMeanNormalisedDifferenceFunction (const std::vector<T>& f
 {
     T cumulativeSum = 0.0;
     unsigned long L = (unsigned long) frame.size() / 2;
+    unsigned long numLags = getNumLags ((unsigned long) frame.size());
     
-    delta.resize(L);
+    differenceFunction (frame, L, numLags);
     
     T *deltaPointer = &delta[0];
 
     // for each time lag tau
-    for (int tau = 0;tau < L;tau++)
+    for (unsigned long tau = 0;tau < numLags;tau++)
     {
-        *deltaPointer = 0.0;
-        
-        // sum all squared differences for all samples up to half way through
-        // the frame between the sample and the sample 'tau' samples away
-        for (int j = 0;j < L;j++)
-        {
-            T diff = frame[j] - frame[j+tau];
-            *deltaPointer += (diff*diff);
-        }
-        
         // calculate the cumulative sum of tau values to date
         cumulativeSum = cumulativeSum + delta[tau];
         
@@ -146,11 +179,296 @@ void Yin<T>::cumulativeMeanNormalisedDifferenceFunction (const std::vector<T>& f
     delta[0] = 1.;
 }
 
+//===========================================================
+template <class T>
+void Yin<T>::differenceFunction (const std::vector<T>& frame, unsigned long windowSize, unsigned long numLags)
+{
+    delta.resize (numLags);
+    
+    autocorrelation (frame, windowSize, numLags);
+    
+    // energy of the window starting at 0 and, updated as it slides, at tau
+    T energyAtZero = 0.0;
+    
+    for (unsigned long j = 0;j < windowSize;j++)
+    {
+        energyAtZero += frame[j] * frame[j];
+    }
+    
+    T energyAtTau = energyAtZero;
+    
+    for (unsigned long tau = 0;tau < numLags;tau++)
+    {
+        if (tau > 0)
+        {
+            energyAtTau += frame[tau + windowSize - 1] * frame[tau + windowSize - 1] - frame[tau - 1] * frame[tau - 1];
+        }
+        
+        // a sum of squares, so any negative value is rounding error
+        T difference = energyAtZero + energyAtTau - 2 * correlation[tau];
+        delta[tau] = difference > 0 ? difference : 0;
+    }
+    
+    // exactly zero by definition; rounding must not leak into the cumulative mean
+    delta[0] = 0.0;
+}
+
+//===========================================================
+template <class T>
+void Yin<T>::autocorrelation (const std::vector<T>& frame, unsigned long windowSize, unsigned long numLags)
+{
+    correlation.resize (numLags);
+    
+#if defined (USE_FFTW) || defined (USE_KISS_FFT) || defined (USE_ACCELERATE_FFT)
+    unsigned long size = getFFTSize (windowSize, numLags);
+    
+    // setAudioFrameSize() has done this already unless the frame size differs;
+    // planning here would run on the caller's (audio) thread
+    if (size != fftSize)
+    {
+        configureFFT (size);
+    }
+    
+    // only the samples some lag can reach take part
+    unsigned long numSamples = windowSize + numLags - 1;
+#endif
+    
+#if defined (USE_FFTW) || defined (USE_KISS_FFT)
+    // transform the window (real part) and the frame (imaginary part) at once
+    for (unsigned long i = 0;i < size;i++)
+    {
+        T window = i < windowSize ? frame[i] : 0;
+        T sample = i < numSamples ? frame[i] : 0;
+        
+#ifdef USE_FFTW
+        fftIn[i][0] = window;
+        fftIn[i][1] = sample;
+#else
+        fftIn[i].r = window;
+        fftIn[i].i = sample;
+#endif
+    }
+    
+#ifdef USE_FFTW
+    fftw_execute (forwardPlan);
+#else
+    kiss_fft (forwardCfg, fftIn, fftOut);
+#endif
+    
+    // separate the two spectra, W[k] = (Z[k] + Z*[-k]) / 2 and X[k] = (Z[k] - Z*[-k]) / 2i,
+    // and form the cross spectrum conj(W[k]) X[k], which is Hermitian
+    for (unsigned long k = 0;k <= size / 2;k++)
+    {
+        unsigned long mirror = (size - k) % size;
+        
+#ifdef USE_FFTW
+        double zr = fftOut[k][0], zi = fftOut[k][1];
+        double mr = fftOut[mirror][0], mi = -fftOut[mirror][1];
+#else
+        double zr = fftOut[k].r, zi = fftOut[k].i;
+        double mr = fftOut[mirror].r, mi = -fftOut[mirror].i;
+#endif
+        
+        double wr = 0.5 * (zr + mr), wi = 0.5 * (zi + mi);
+        double xr = 0.5 * (zi - mi), xi = -0.5 * (zr - mr);
+        
+        double pr = wr * xr + wi * xi;
+        double pi = wr * xi - wi * xr;
+        
+#ifdef USE_FFTW
+        fftIn[k][0] = pr;
+        fftIn[k][1] = pi;
+        fftIn[mirror][0] = pr;
+        fftIn[mirror][1] = -pi;
+#else
+        fftIn[k].r = pr;
+        fftIn[k].i = pi;
+        fftIn[mirror].r = pr;
+        fftIn[mirror].i = -pi;
+#endif
+    }
+    
+#ifdef USE_FFTW
+    fftw_execute (inversePlan);
+#else
+    kiss_fft (inverseCfg, fftIn, fftOut);
+#endif
+    
+    // both libraries leave the inverse transform unnormalised
+    for (unsigned long tau = 0;tau < numLags;tau++)
+    {
+#ifdef USE_FFTW
+        correlation[tau] = (T) (fftOut[tau][0] / size);
+#else
+        correlation[tau] = (T) (fftOut[tau].r / size);
+#endif
+    }
+    
+#elif defined (USE_ACCELERATE_FFT)
+    for (unsigned long i = 0;i < size;i++)
+    {
+        fftBuffer[i] = i < windowSize ? frame[i] : 0;
+    }
+    
+    accelerateFFT.performHalfSpectrumFFT (&fftBuffer[0], &windowReal[0], &windowImag[0]);
+    
+    for (unsigned long i = 0;i < size;i++)
+    {
+        fftBuffer[i] = i < numSamples ? frame[i] : 0;
+    }
+    
+    accelerateFFT.performHalfSpectrumFFT (&fftBuffer[0], &frameReal[0], &frameImag[0]);
+    
+    // cross spectrum conj(W[k]) X[k], in place of the frame spectrum
+    for (unsigned long k = 0;k <= size / 2;k++)
+    {
+        T pr = windowReal[k] * frameReal[k] + windowImag[k] * frameImag[k];
+        T pi = windowReal[k] * frameImag[k] - windowImag[k] * frameReal[k];
+        
+        frameReal[k] = pr;
+        frameImag[k] = pi;
+    }
+    
+    accelerateFFT.performInverseFFT (&frameReal[0], &frameImag[0], &fftBuffer[0]);
+    
+    for (unsigned long tau = 0;tau < numLags;tau++)
+    {
+        correlation[tau] = fftBuffer[tau];
+    }
+    
+#else
+    // no FFT library: direct sums, still limited to the lags needed
+    for (unsigned long tau = 0;tau < numLags;tau++)
+    {
+        T sum = 0.0;
+        
+        for (unsigned long j = 0;j < windowSize;j++)
+        {
+            sum += frame[j] * frame[j + tau];
+        }
+        
+        correlation[tau] = sum;
+    }
+#endif
+}
+
+//===========================================================
+template <class T>
+unsigned long Yin<T>::getNumLags (unsigned long frameSize)
+{
+    unsigned long L = frameSize / 2;
+    
+    // lags beyond the longest period of interest are never computed; two extra
+    // values keep the neighbours needed by the minimum search and interpolation
+    if ((maxPeriod > 0) && ((unsigned long) maxPeriod + 2 < L))
+    {
+        return (unsigned long) maxPeriod + 2;
+    }
+    
+    return L;
+}
+
+//===========================================================
+template <class T>
+unsigned long Yin<T>::getFFTSize (unsigned long windowSize, unsigned long numLags)
+{
+    unsigned long size = 1;
+    
+    while (size < windowSize + numLags)
+    {
+        size *= 2;
+    }
+    
+    return size;
+}
+
+//===========================================================
+template <class T>
+void Yin<T>::prepareFFT()
+{
+#if defined (USE_FFTW) || defined (USE_KISS_FFT) || defined (USE_ACCELERATE_FFT)
+    if (audioFrameSize == 0)
+    {
+        return;
+    }
+    
+    unsigned long size = getFFTSize (audioFrameSize / 2, getNumLags (audioFrameSize));
+    
+    if (size != fftSize)
+    {
+        configureFFT (size);
+    }
+#endif
+}
+
+//===========================================================
+template <class T>
+void Yin<T>::configureFFT (unsigned long size)
+{
+    freeFFT();
+    
+#ifdef USE_FFTW
+    fftIn = (fftw_complex*)fftw_malloc (sizeof (fftw_complex) * size);
+    fftOut = (fftw_complex*)fftw_malloc (sizeof (fftw_complex) * size);
+    
+    forwardPlan = fftw_plan_dft_1d ((int) size, fftIn, fftOut, FFTW_FORWARD, FFTW_ESTIMATE);
+    inversePlan = fftw_plan_dft_1d ((int) size, fftIn, fftOut, FFTW_BACKWARD, FFTW_ESTIMATE);
+#endif
+    
+#ifdef USE_KISS_FFT
+    fftIn = new kiss_fft_cpx[size];
+    fftOut = new kiss_fft_cpx[size];
+    
+    forwardCfg = kiss_fft_alloc ((int) size, 0, 0, 0);
+    inverseCfg = kiss_fft_alloc ((int) size, 1, 0, 0);
+#endif
+    
+#ifdef USE_ACCELERATE_FFT
+    accelerateFFT.setAudioFrameSize ((int) size);
+    
+    // spectra of real signals, bins 0 .. N/2
+    fftBuffer.resize (size);
+    windowReal.resize (size / 2 + 1);
+    windowImag.resize (size / 2 + 1);
+    frameReal.resize (size / 2 + 1);
+    frameImag.resize (size / 2 + 1);
+#endif
+    
+    fftSize = size;
+}
+
+//===========================================================
+template <class T>
+void Yin<T>::freeFFT()
+{
+    if (fftSize == 0)
+    {
+        return;
+    }
+    
+#ifdef USE_FFTW
+    fftw_destroy_plan (forwardPlan);
+    fftw_destroy_plan (inversePlan);
+    
+    fftw_free (fftIn);
+    fftw_free (fftOut);
+#endif
+    
+#ifdef USE_KISS_FFT
+    free (forwardCfg);
+    free (inverseCfg);
+    
+    delete[] fftIn;
+    delete[] fftOut;
+#endif
+    
+    fftSize = 0;
+}
+
 //===========================================================
 template <class T>
 unsigned long Yin<T>::getPeriodCandidate (const std::vector<T>& delta)
 {
-    unsigned long minPeriod = 30;
     unsigned long period;
     
     T thresh = 0.1;
@@ -160,7 +478,8 @@ unsigned long Yin<T>::getPeriodCandidate (const std::vector<T>& delta)
     T minVal = 100000;
     unsigned long minInd = 0;
     
-    for (unsigned long i = minPeriod; i < (delta.size() - 1); i++)
+    // no shorter period than setMaxFrequency() allows
+    for (unsigned long i = (unsigned long) minPeriod; i < (delta.size() - 1); i++)
     {
         if (delta[i] < minVal)
         {
@@ -27,6 +27,18 @@
 #include <vector>
 #include <cmath>
 
+#ifdef USE_FFTW
+#include "fftw3.h"
+#endif
+
+#ifdef USE_KISS_FFT
+#include "kiss_fft.h"
+#endif
+
+#ifdef USE_ACCELERATE_FFT
+#include "../fft/AccelerateFFT.h"
+#endif
+
 //===========================================================
 /** template class for the pitch detection algorithm Yin.
  * Instantiations of the class should be of either 'float' or
@@ -43,6 +55,9 @@ public:
      */
     Yin (int samplingFrequency);
     
+    /** destructor */
+    ~Yin();
+    
     //===========================================================
     /** sets the sampling frequency used to calculate pitch values
      * @param samplingFrequency the sampling frequency
@@ -54,6 +69,18 @@ public:
      */
     void setMaxFrequency (T maxFreq);
     
+    /** sets the minimum frequency that the algorithm will return. Lags
+     * longer than the matching period are never computed
+     * @param minFreq the minimum frequency, or zero for no limit
+     */
+    void setMinFrequency (T minFreq);
+    
+    /** sets the size of the audio frames that will be passed to pitchYin() and
+     * sets up the FFT for it, so that pitchYin() never has to
+     * @param frameSize the audio frame size
+     */
+    void setAudioFrameSize (unsigned long frameSize);
+    
     //===========================================================
     /** @returns the maximum frequency that the algorithm will return */
     T getMaxFrequency()
@@ -61,6 +88,12 @@ public:
         return ((T) fs) / ((T) minPeriod);
     }
     
+    /** @returns the minimum frequency that the algorithm will return, or zero if there is no limit */
+    T getMinFrequency()
+    {
+        return maxPeriod > 0 ? ((T) fs) / ((T) maxPeriod) : 0;
+    }
+    
     //===========================================================
     /** calculates the pitch of the audio frame passed to it
      * @param frame an audio frame stored in a vector
@@ -106,6 +139,47 @@ private:
      */
     void cumulativeMeanNormalisedDifferenceFunction (const std::vector<T>& frame);
     
+    /** calculates the difference function d(tau) for tau = 0 .. numLags - 1 from
+     * the energy and autocorrelation terms, d(tau) = e(0) + e(tau) - 2 r(tau),
+     * where every sum runs over windowSize samples
+     * @param frame the audio frame
+     * @param windowSize the number of samples in each sum
+     * @param numLags the number of lags to calculate, windowSize + numLags - 1 <= frame.size()
+     */
+    void differenceFunction (const std::vector<T>& frame, unsigned long windowSize, unsigned long numLags);
+    
+    /** calculates r(tau) = sum of frame[j] * frame[j + tau] for j < windowSize into
+     * the correlation vector, using the FFT when one is available
+     * @param frame the audio frame
+     * @param windowSize the number of samples in each sum
+     * @param numLags the number of lags to calculate
+     */
+    void autocorrelation (const std::vector<T>& frame, unsigned long windowSize, unsigned long numLags);
+    
+    /** @returns the number of lags calculated for a frame of the given size, which
+     * setMinFrequency() limits to the longest period of interest
+     * @param frameSize the audio frame size
+     */
+    unsigned long getNumLags (unsigned long frameSize);
+    
+    /** @returns the FFT size autocorrelation() uses: linear (not circular) correlation
+     * needs room for the window plus every lag
+     * @param windowSize the number of samples in each sum
+     * @param numLags the number of lags to calculate
+     */
+    unsigned long getFFTSize (unsigned long windowSize, unsigned long numLags);
+    
+    /** sets up the FFT for frames of the size given to setAudioFrameSize(), if any */
+    void prepareFFT();
+    
+    /** sets up the FFT used by autocorrelation() for transforms of the given size
+     * @param size the transform size, a power of two
+     */
+    void configureFFT (unsigned long size);
+    
+    /** frees any FFT-related data */
+    void freeFFT();
+    
 	T round (T val)
 	{
 		return floor(val + 0.5);
@@ -120,7 +194,42 @@ private:
     /** the minimum period the algorithm will look for. this is set indirectly by setMaxFrequency() */
     int minPeriod;
     
+    /** the maximum period the algorithm will look for, or zero for half the frame. this is set indirectly by setMinFrequency() */
+    int maxPeriod;
+    
     std::vector<T> delta;
+    
+    /** the autocorrelation of the current frame, one value per lag */
+    std::vector<T> correlation;
+    
+    /** the size of the currently configured FFT, zero if none */
+    unsigned long fftSize;
+    
+    /** the audio frame size set by setAudioFrameSize(), zero if not set */
+    unsigned long audioFrameSize;
+    
+#ifdef USE_FFTW
+    fftw_plan forwardPlan;   /**< fftw plan for the forward transform */
+    fftw_plan inversePlan;   /**< fftw plan for the inverse transform */
+    fftw_complex* fftIn;     /**< complex fft input */
+    fftw_complex* fftOut;    /**< complex fft output */
+#endif
+    
+#ifdef USE_KISS_FFT
+    kiss_fft_cfg forwardCfg; /**< Kiss FFT configuration for the forward transform */
+    kiss_fft_cfg inverseCfg; /**< Kiss FFT configuration for the inverse transform */
+    kiss_fft_cpx* fftIn;     /**< complex fft input */
+    kiss_fft_cpx* fftOut;    /**< complex fft output */
+#endif
+    
+#ifdef USE_ACCELERATE_FFT
+    AccelerateFFT<T> accelerateFFT;
+    std::vector<T> fftBuffer;    /**< time domain buffer for the transforms */
+    std::vector<T> windowReal;   /**< spectrum of the analysis window, real part */
+    std::vector<T> windowImag;   /**< spectrum of the analysis window, imaginary part */
+    std::vector<T> frameReal;    /**< spectrum of the frame, real part */
+    std::vector<T> frameImag;    /**< spectrum of the frame, imaginary part */
+#endif
 };
 
 #endif
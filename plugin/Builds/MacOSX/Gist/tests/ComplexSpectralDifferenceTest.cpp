@@ -0,0 +1,228 @@
+//=======================================================================
+/** @file ComplexSpectralDifferenceTest.cpp
+ *  @brief Checks OnsetDetectionFunction::complexSpectralDifference() against
+ *  the atan2/princarg implementation it replaced, and times both
+ */
+//=======================================================================
+
+#include "TestHarness.h"
+#include "onset-detection-functions/OnsetDetectionFunction.h"
+
+#include <string>
+
+using namespace TestHarness;
+
+//===========================================================
+/** the previous implementation: phases from atan2 over all N bins of the
+ * mirrored spectrum, the deviation wrapped by princarg() */
+template <class T>
+class ReferenceComplexSpectralDifference
+{
+public:
+    ReferenceComplexSpectralDifference (int frameSize)
+     :  prevPhase (frameSize, 0),
+        prevPhase2 (frameSize, 0),
+        prevMagnitude (frameSize, 0)
+    {
+    }
+
+    T process (const std::vector<T>& fftReal, const std::vector<T>& fftImag)
+    {
+        T sum = 0;
+
+        for (size_t i = 0; i < fftReal.size(); i++)
+        {
+            T phaseVal = atan2 (fftImag[i], fftReal[i]);
+            T magVal = sqrt ((fftReal[i] * fftReal[i]) + (fftImag[i] * fftImag[i]));
+            T dev = phaseVal - (2 * prevPhase[i]) + prevPhase2[i];
+            T pdev = princarg (dev);
+            T magDiff = magVal - prevMagnitude[i];
+            T phaseDiff = -magVal * sin (pdev);
+
+            sum = sum + sqrt ((magDiff * magDiff) + (phaseDiff * phaseDiff));
+
+            prevPhase2[i] = prevPhase[i];
+            prevPhase[i] = phaseVal;
+            prevMagnitude[i] = magVal;
+        }
+
+        return sum;
+    }
+
+private:
+    static T princarg (T phaseVal)
+    {
+        while (phaseVal <= (-M_PI))
+            phaseVal = phaseVal + (2 * M_PI);
+
+        while (phaseVal > M_PI)
+            phaseVal = phaseVal - (2 * M_PI);
+
+        return phaseVal;
+    }
+
+    std::vector<T> prevPhase;
+    std::vector<T> prevPhase2;
+    std::vector<T> prevMagnitude;
+};
+
+//===========================================================
+/** the kinds of frame a sequence is made of */
+enum FrameKind
+{
+    RandomFrame,    /**< random bins, unrelated to the previous frame */
+    ToneFrame,      /**< steady magnitudes with phases advancing at a constant rate per bin */
+    SilentFrame     /**< all bins zero */
+};
+
+/** one frame of a real signal's spectrum, bins 0 to N/2 */
+template <class T>
+void makeFrame (FrameKind kind, int frameSize, int frameIndex, std::vector<T>& real, std::vector<T>& imag)
+{
+    int nyquistBin = frameSize / 2;
+    std::vector<T> magnitudes = randomValues<T> (nyquistBin + 1, 0, 1, 7);
+    std::vector<T> values = randomValues<T> (2 * (nyquistBin + 1), -1, 1, (uint32_t)frameIndex + 100);
+
+    for (int k = 0; k <= nyquistBin; k++)
+    {
+        if (kind == RandomFrame)
+        {
+            real[k] = values[2 * k];
+            imag[k] = values[2 * k + 1];
+        }
+        else if (kind == ToneFrame)
+        {
+            double phase = 0.37 * k * frameIndex;
+            real[k] = magnitudes[k] * (T)cos (phase);
+            imag[k] = magnitudes[k] * (T)sin (phase);
+        }
+        else
+        {
+            real[k] = 0;
+            imag[k] = 0;
+        }
+    }
+
+    // DC and Nyquist are real for a real signal
+    imag[0] = 0;
+    imag[nyquistBin] = 0;
+}
+
+/** the full N-bin spectrum the reference reads: bin N - k is the conjugate of bin k */
+template <class T>
+void mirror (const std::vector<T>& real, const std::vector<T>& imag, std::vector<T>& fullReal, std::vector<T>& fullImag)
+{
+    int frameSize = (int)fullReal.size();
+
+    for (int k = 0; k < frameSize; k++)
+    {
+        int bin = k <= frameSize / 2 ? k : frameSize - k;
+        fullReal[k] = real[bin];
+        fullImag[k] = k <= frameSize / 2 ? imag[bin] : -imag[bin];
+    }
+}
+
+//===========================================================
+/** runs a sequence of frames through both implementations; each frame's
+ * difference is relative to the magnitude of the two frames involved, so
+ * frames whose value is close to zero are still held to the same bound */
+template <class T>
+void checkSequence (const std::vector<FrameKind>& kinds, int frameSize, double tolerance, const std::string& name)
+{
+    OnsetDetectionFunction<T> onsetDetectionFunction (frameSize);
+    ReferenceComplexSpectralDifference<T> reference (frameSize);
+
+    std::vector<T> real (frameSize / 2 + 1), imag (frameSize / 2 + 1);
+    std::vector<T> fullReal (frameSize), fullImag (frameSize);
+    double prevMagnitudeSum = 0;
+    double worst = 0;
+
+    for (int frame = 0; frame < (int)kinds.size(); frame++)
+    {
+        makeFrame<T> (kinds[frame], frameSize, frame, real, imag);
+        mirror<T> (real, imag, fullReal, fullImag);
+
+        double magnitudeSum = 0;
+
+        for (int k = 0; k < frameSize; k++)
+            magnitudeSum += std::sqrt ((double)fullReal[k] * fullReal[k] + (double)fullImag[k] * fullImag[k]);
+
+        double expected = reference.process (fullReal, fullImag);
+        double value = onsetDetectionFunction.complexSpectralDifference (real, imag);
+        double scale = std::max (magnitudeSum + prevMagnitudeSum, 1e-30);
+
+        worst = std::max (worst, std::fabs (value - expected) / scale);
+        prevMagnitudeSum = magnitudeSum;
+    }
+
+    char message[160];
+    snprintf (message, sizeof (message), "%s, worst relative error %.2e", name.c_str(), worst);
+    check (worst <= tolerance, message);
+}
+
+template <class T>
+void checkAccuracy (const char* type, double tolerance)
+{
+    for (int frameSize : { 8, 512, 1024, 4096 })
+    {
+        std::string size = std::string (type) + " N=" + std::to_string (frameSize);
+
+        std::vector<FrameKind> random (40, RandomFrame);
+        std::vector<FrameKind> tone (40, ToneFrame);
+        std::vector<FrameKind> silent (10, SilentFrame);
+
+        // silence at the start, in the middle and at the end of a signal
+        std::vector<FrameKind> mixed;
+
+        for (FrameKind kind : { SilentFrame, SilentFrame, RandomFrame, RandomFrame, ToneFrame, ToneFrame, ToneFrame,
+                                SilentFrame, SilentFrame, SilentFrame, ToneFrame, RandomFrame, SilentFrame })
+            mixed.push_back (kind);
+
+        checkSequence<T> (random, frameSize, tolerance, size + " random frames");
+        checkSequence<T> (tone, frameSize, tolerance, size + " tone frames");
+        checkSequence<T> (silent, frameSize, 0.0, size + " silent frames");
+        checkSequence<T> (mixed, frameSize, tolerance, size + " mixed frames");
+    }
+}
+
+//===========================================================
+template <class T>
+void benchmark (const char* type)
+{
+    for (int frameSize : { 512, 1024, 2048, 4096 })
+    {
+        OnsetDetectionFunction<T> onsetDetectionFunction (frameSize);
+        ReferenceComplexSpectralDifference<T> reference (frameSize);
+
+        std::vector<T> real (frameSize / 2 + 1), imag (frameSize / 2 + 1);
+        std::vector<T> fullReal (frameSize), fullImag (frameSize);
+        makeFrame<T> (RandomFrame, frameSize, 1, real, imag);
+        mirror<T> (real, imag, fullReal, fullImag);
+
+        double before = nanosecondsPerCall ([&]
+        {
+            sink = reference.process (fullReal, fullImag);
+        });
+
+        double after = nanosecondsPerCall ([&]
+        {
+            sink = onsetDetectionFunction.complexSpectralDifference (real, imag);
+        });
+
+        printTiming ("atan2/princarg vs phasors", type, frameSize, before, after);
+    }
+}
+
+//===========================================================
+int main()
+{
+    checkAccuracy<double> ("double", 1e-12);
+    checkAccuracy<float> ("float", 1e-5);
+
+    benchmark<float> ("float");
+    benchmark<double> ("double");
+
+    printf ("complexSpectralDifference: %d failed checks\n", failures);
+
+    return failures == 0 ? 0 : 1;
+}
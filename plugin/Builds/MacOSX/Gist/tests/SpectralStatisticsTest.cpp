@@ -0,0 +1,156 @@
+//=======================================================================
+/** @file SpectralStatisticsTest.cpp
+ *  @brief Checks CoreFrequencyDomainFeatures::spectralStatistics() against
+ *  the five per-feature functions it stands in for, and times both
+ */
+//=======================================================================
+
+#include "TestHarness.h"
+#include "core/CoreFrequencyDomainFeatures.h"
+
+#include <string>
+
+using namespace TestHarness;
+
+//===========================================================
+/** the five features as Gist computed them one call at a time */
+template <class T>
+SpectralStatistics<T> separateFeatures (CoreFrequencyDomainFeatures<T>& features, const std::vector<T>& magnitudes, T percentile)
+{
+    SpectralStatistics<T> statistics;
+
+    statistics.centroid = features.spectralCentroid (magnitudes);
+    statistics.crest = features.spectralCrest (magnitudes);
+    statistics.flatness = features.spectralFlatness (magnitudes);
+    statistics.rolloff = features.spectralRolloff (magnitudes, percentile);
+    statistics.kurtosis = features.spectralKurtosis (magnitudes);
+
+    return statistics;
+}
+
+//===========================================================
+/** checks every feature against the separate calls
+ * @param tolerance the relative error allowed for the summed features
+ * @param rolloffBins how many bins the rolloff may move, from summation order alone
+ */
+template <class T>
+void compare (const std::vector<T>& magnitudes, T percentile, double tolerance, int rolloffBins, const std::string& name)
+{
+    CoreFrequencyDomainFeatures<T> features;
+    SpectralStatistics<T> expected = separateFeatures (features, magnitudes, percentile);
+    SpectralStatistics<T> statistics = features.spectralStatistics (magnitudes, percentile);
+    double numBins = (double)magnitudes.size();
+
+    check (relativeError (statistics.centroid, expected.centroid) <= tolerance, (name + ": centroid").c_str());
+    check (relativeError (statistics.crest, expected.crest) <= tolerance, (name + ": crest").c_str());
+    check (relativeError (statistics.flatness, expected.flatness) <= tolerance, (name + ": flatness").c_str());
+    check (relativeError (statistics.kurtosis, expected.kurtosis) <= tolerance, (name + ": kurtosis").c_str());
+    check (std::fabs (statistics.rolloff - expected.rolloff) * numBins <= rolloffBins + 0.5, (name + ": rolloff").c_str());
+}
+
+//===========================================================
+template <class T>
+void checkAccuracy (const char* type, double tolerance)
+{
+    // random spectra, including sizes that leave a partial block of bins
+    for (int numBins : { 1, 3, 6, 513, 1021, 1024, 2048 })
+    {
+        for (uint32_t seed = 1; seed <= 20; seed++)
+        {
+            std::vector<T> magnitudes = randomValues<T> (numBins, 0, 10, seed);
+            std::string name = std::string (type) + " random N=" + std::to_string (numBins) + " seed " + std::to_string (seed);
+
+            // float sums in the separate calls can cross the threshold a bin away
+            compare<T> (magnitudes, (T)0.85, tolerance, sizeof (T) == sizeof (float) ? 1 : 0, name);
+        }
+    }
+
+    // silence: the documented values for an all-zero spectrum
+    for (int numBins : { 4, 7, 1024 })
+    {
+        compare<T> (std::vector<T> (numBins, 0), (T)0.85, 0.0, 0, std::string (type) + " silent N=" + std::to_string (numBins));
+    }
+}
+
+//===========================================================
+/** pins the rolloff, which skips whole blocks of bins while their total stays
+ * under the threshold, to the bin-by-bin search of spectralRolloff(). Small
+ * integer magnitudes keep every sum exact, so the bin must match exactly,
+ * wherever in a block or the trailing partial block the threshold is crossed */
+void checkRolloff()
+{
+    CoreFrequencyDomainFeatures<double> features;
+
+    for (int numBins = 1; numBins <= 40; numBins++)
+    {
+        std::vector<std::vector<double>> spectra;
+
+        // a single non-zero bin at every position, then random small integers
+        for (int spike = 0; spike < numBins; spike++)
+        {
+            spectra.push_back (std::vector<double> (numBins, 0.0));
+            spectra.back()[spike] = 1.0;
+        }
+
+        for (uint32_t seed = 1; seed <= 10; seed++)
+        {
+            std::vector<double> values = randomValues<double> (numBins, 0, 4, seed);
+
+            for (double& value : values)
+                value = std::floor (value);
+
+            spectra.push_back (values);
+        }
+
+        for (const std::vector<double>& magnitudes : spectra)
+        {
+            for (double percentile : { 0.0, 0.25, 0.5, 0.85, 0.99, 1.0 })
+            {
+                double expected = features.spectralRolloff (magnitudes, percentile);
+                double rolloff = features.spectralStatistics (magnitudes, percentile).rolloff;
+                std::string name = "rolloff N=" + std::to_string (numBins) + " percentile " + std::to_string (percentile);
+
+                check (rolloff == expected, name.c_str());
+            }
+        }
+    }
+}
+
+//===========================================================
+template <class T>
+void benchmark (const char* type)
+{
+    CoreFrequencyDomainFeatures<T> features;
+
+    for (int numBins : { 256, 512, 1024, 2048, 4096 })
+    {
+        std::vector<T> magnitudes = randomValues<T> (numBins, 0, 10);
+
+        double separate = nanosecondsPerCall ([&]
+        {
+            sink = separateFeatures (features, magnitudes, (T)0.85).kurtosis;
+        });
+
+        double together = nanosecondsPerCall ([&]
+        {
+            sink = features.spectralStatistics (magnitudes).kurtosis;
+        });
+
+        printTiming ("five calls vs spectralStatistics", type, numBins, separate, together);
+    }
+}
+
+//===========================================================
+int main()
+{
+    checkAccuracy<double> ("double", 1e-9);
+    checkAccuracy<float> ("float", 1e-4);
+    checkRolloff();
+
+    benchmark<float> ("float");
+    benchmark<double> ("double");
+
+    printf ("spectralStatistics: %d failed checks\n", failures);
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+//=======================================================================
+/** @file TestHarness.h
+ *  @brief Helpers shared by the Gist checks in this directory: deterministic
+ *  test data, tolerance checks that count failures, and a timer
+ */
+//=======================================================================
+
+#ifndef __GIST__TESTHARNESS__
+#define __GIST__TESTHARNESS__
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace TestHarness
+{
+    //===========================================================
+    /** the number of failed checks so far, the exit status of each test */
+    inline int failures = 0;
+
+    /** records a failure and prints the message if the check does not hold
+     * @param condition the result of the check
+     * @param message what was checked, printed on failure
+     */
+    inline void check (bool condition, const char* message)
+    {
+        if (!condition)
+        {
+            failures++;
+            printf ("FAILED: %s\n", message);
+        }
+    }
+
+    /** @returns the error of a value relative to the expected one, or the absolute
+     * error when the expected value is zero
+     */
+    inline double relativeError (double value, double expected)
+    {
+        double scale = std::fabs (expected) > 0 ? std::fabs (expected) : 1.0;
+
+        return std::fabs (value - expected) / scale;
+    }
+
+    //===========================================================
+    /** @returns count deterministic pseudo-random values in [low, high)
+     * @param seed the generator seed, so that runs are repeatable
+     */
+    template <class T>
+    std::vector<T> randomValues (size_t count, T low, T high, uint32_t seed = 1)
+    {
+        std::vector<T> values (count);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            values[i] = low + (high - low) * (T)((double)(seed >> 8) / 16777216.0);
+        }
+
+        return values;
+    }
+
+    //===========================================================
+    /** @returns the time per call of fn in nanoseconds, the best of several runs
+     * that each repeat the call for about 20 ms
+     */
+    template <typename Function>
+    double nanosecondsPerCall (Function&& fn, int runs = 5)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        uint64_t calls = 1;
+
+        while (true)
+        {
+            auto start = Clock::now();
+
+            for (uint64_t i = 0; i < calls; i++)
+                fn();
+
+            if (Clock::now() - start >= std::chrono::milliseconds (20))
+                break;
+
+            calls *= 2;
+        }
+
+        double best = 1e300;
+
+        for (int run = 0; run < runs; run++)
+        {
+            auto start = Clock::now();
+
+            for (uint64_t i = 0; i < calls; i++)
+                fn();
+
+            std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+            best = std::min (best, elapsed.count() / (double)calls);
+        }
+
+        return best;
+    }
+
+    /** keeps the optimiser from discarding a result that is only timed */
+    inline volatile double sink;
+
+    /** prints one benchmark line, both timings and their ratio */
+    inline void printTiming (const char* name, const char* type, int size, double before, double after)
+    {
+        printf ("%-30s %-6s N=%-5d %10.0f ns %10.0f ns  %5.2fx\n", name, type, size, before, after, before / after);
+    }
+}
+
+#endif
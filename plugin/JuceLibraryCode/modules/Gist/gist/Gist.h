@@ -46,6 +46,7 @@
 
 #ifdef USE_KISS_FFT
 #include "kiss_fft.h"
+#include "kiss_fftr.h"
 #endif
 
 #ifdef USE_ACCELERATE_FFT
@@ -54,6 +55,37 @@
 
 #include "fft/WindowFunctions.h"
 
+//=======================================================================
+/** Flags for the features Gist can compute, combined with | into a feature mask */
+enum GistFeature
+{
+    RootMeanSquareFeature                   = 1 << 0,
+    PeakEnergyFeature                       = 1 << 1,
+    ZeroCrossingRateFeature                 = 1 << 2,
+    SpectralCentroidFeature                 = 1 << 3,
+    SpectralCrestFeature                    = 1 << 4,
+    SpectralFlatnessFeature                 = 1 << 5,
+    SpectralRolloffFeature                  = 1 << 6,
+    SpectralKurtosisFeature                 = 1 << 7,
+    EnergyDifferenceFeature                 = 1 << 8,
+    SpectralDifferenceFeature               = 1 << 9,
+    SpectralDifferenceHWRFeature            = 1 << 10,
+    ComplexSpectralDifferenceFeature        = 1 << 11,
+    HighFrequencyContentFeature             = 1 << 12,
+    PitchFeature                            = 1 << 13,
+    MelFrequencySpectrumFeature             = 1 << 14,
+    MelFrequencyCepstralCoefficientsFeature = 1 << 15,
+    
+    AllFeatures                             = (1 << 16) - 1
+};
+
+/** The number of individual flags in GistFeature */
+const int numGistFeatures = 16;
+
+/** The features computed together by CoreFrequencyDomainFeatures::spectralStatistics() */
+const int spectralStatisticsFeatures = SpectralCentroidFeature | SpectralCrestFeature | SpectralFlatnessFeature
+                                       | SpectralRolloffFeature | SpectralKurtosisFeature;
+
 //=======================================================================
 /** Class for all performing all Gist audio analyses */
 template <class T>
@@ -83,6 +115,14 @@ public:
      */
     void setSamplingFrequency (int fs);
     
+    /** Set the range of pitches that pitch() can return. Lags longer than the period
+     * of the lowest pitch are never computed, and the FFT for the rest is set up here
+     * rather than on the first call to pitch().
+     * @param minFrequency the lowest pitch in Hz, or zero for no limit
+     * @param maxFrequency the highest pitch in Hz
+     */
+    void setPitchRange (T minFrequency, T maxFrequency);
+    
     //=======================================================================
     /** @Returns the audio frame size currently being used */
     int getAudioFrameSize();
@@ -90,6 +130,19 @@ public:
     /** @Returns the audio sampling frequency being used for analysis */
     int getSamplingFrequency();
 
+    //=======================================================================
+    /** Select the features to compute. Each selected feature is computed the first time it
+     * is requested after processAudioFrame(), and intermediate results (frame energy, magnitude
+     * sum, power spectrum) are shared between features. Requesting a feature that is not in the
+     * mask is not an error: it returns 0, or an empty vector for the mel-frequency spectrum and
+     * MFCCs. The FFT is only performed once a feature needs the spectrum.
+     * @param mask GistFeature flags combined with |, AllFeatures by default
+     */
+    void setFeatureMask (int mask);
+
+    /** @Returns the current feature mask */
+    int getFeatureMask();
+
     //=======================================================================
     /** Process an audio frame
      * @param audioFrame a vector containing audio samples
@@ -102,7 +155,7 @@ public:
      */
     void processAudioFrame (const T* frame, int numSamples);
 
-    /** Gist automatically calculates the magnitude spectrum when processAudioFrame() is called, this function returns it.
+    /** Returns the magnitude spectrum of the current audio frame, performing the FFT if no feature has needed it yet.
      @returns the current magnitude spectrum */
     const std::vector<T>& getMagnitudeSpectrum();
 
@@ -158,10 +211,12 @@ public:
 
     //=========================== MFCCs =============================
     
-    /** Calculates the Mel Frequency Spectrum */
+    /** Calculates the Mel Frequency Spectrum
+     * @Returns the mel-frequency spectrum, or an empty vector if it is not in the feature mask */
     const std::vector<T>& getMelFrequencySpectrum();
 
-    /** Calculates the Mel-frequency Cepstral Coefficients */
+    /** Calculates the Mel-frequency Cepstral Coefficients
+     * @Returns the MFCCs, or an empty vector if they are not in the feature mask */
     const std::vector<T>& getMelFrequencyCepstralCoefficients();
     
 private:
@@ -176,22 +231,52 @@ private:
     /** perform the FFT on the current audio frame */
     void performFFT();
 
+    /** Perform the FFT for the current frame, unless that has already been done */
+    void updateSpectrum();
+
+    //=======================================================================
+    /** Forget everything computed for the previous frame */
+    void clearComputedFeatures();
+
+    /** @Returns true if the feature is selected and has not been computed yet for the current frame */
+    bool needsComputing (GistFeature feature);
+
+    /** Store a computed feature value for the current frame */
+    void storeFeature (GistFeature feature, T value);
+
+    /** @Returns the stored value of a feature for the current frame, or 0 if it was not computed */
+    T storedFeature (GistFeature feature);
+
+    /** @Returns true if more than one of the spectralStatisticsFeatures is selected, in which
+     * case they are computed together by CoreFrequencyDomainFeatures::spectralStatistics() */
+    bool usesSpectralStatistics();
+
+    /** Compute and store all the spectralStatisticsFeatures for the current frame */
+    void computeSpectralStatistics();
+
+    /** @Returns the sum of squared samples of the current frame */
+    T getFrameEnergy();
+
+    /** @Returns the sum of the magnitude spectrum of the current frame */
+    T getSumOfMagnitudes();
+
     //=======================================================================
 
 #ifdef USE_FFTW
-    fftw_plan p;          /**< fftw plan */
-    fftw_complex* fftIn;  /**< to hold complex fft values for input */
-    fftw_complex* fftOut; /**< to hold complex fft values for output */
+    fftw_plan p;          /**< fftw real to complex plan */
+    double* fftIn;        /**< to hold the windowed audio frame */
+    fftw_complex* fftOut; /**< to hold the N/2 + 1 complex fft values for output */
 #endif
 
 #ifdef USE_KISS_FFT
-    kiss_fft_cfg cfg;     /**< Kiss FFT configuration */
-    kiss_fft_cpx* fftIn;  /**< FFT input samples, in complex form */
-    kiss_fft_cpx* fftOut; /**< FFT output samples, in complex form */
+    kiss_fftr_cfg cfg;        /**< Kiss FFT real input configuration */
+    kiss_fft_scalar* fftIn;   /**< FFT input samples, the windowed audio frame */
+    kiss_fft_cpx* fftOut;     /**< the N/2 + 1 FFT output samples, in complex form */
 #endif
     
 #ifdef USE_ACCELERATE_FFT
     AccelerateFFT<T> accelerateFFT;
+    std::vector<T> fftIn;     /**< the windowed audio frame */
 #endif
 
     int frameSize;                    /**< The audio frame size */
@@ -200,12 +285,24 @@ private:
 
     std::vector<T> audioFrame;        /**< The current audio frame */
     std::vector<T> windowFunction;    /**< The window function used in FFT processing */
-    std::vector<T> fftReal;           /**< The real part of the FFT for the current audio frame */
-    std::vector<T> fftImag;           /**< The imaginary part of the FFT for the current audio frame */
+    std::vector<T> fftReal;           /**< The real part of the FFT for the current audio frame, bins 0 to N/2 */
+    std::vector<T> fftImag;           /**< The imaginary part of the FFT for the current audio frame, bins 0 to N/2 */
     std::vector<T> magnitudeSpectrum; /**< The magnitude spectrum of the current audio frame */
+    std::vector<T> powerSpectrum;     /**< The power (squared magnitude) spectrum of the current audio frame */
 
     bool fftConfigured;
 
+    int featureMask;                  /**< The features selected with setFeatureMask() */
+    int computedFeatures;             /**< The features already computed for the current frame */
+    T featureValues[numGistFeatures]; /**< The computed feature values, one per GistFeature flag */
+    const std::vector<T> noValues;    /**< Returned for vector features that are not selected */
+
+    bool spectrumReady;               /**< Whether the FFT has been performed for the current frame */
+    bool frameEnergyReady;            /**< Whether frameEnergy is valid for the current frame */
+    bool sumOfMagnitudesReady;        /**< Whether sumOfMagnitudes is valid for the current frame */
+    T frameEnergy;                    /**< The sum of squared samples of the current frame */
+    T sumOfMagnitudes;                /**< The sum of the magnitude spectrum of the current frame */
+
     /** object to compute core time domain features */
     CoreTimeDomainFeatures<T> coreTimeDomainFeatures;
 
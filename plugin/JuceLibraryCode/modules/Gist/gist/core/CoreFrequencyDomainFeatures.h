@@ -28,6 +28,17 @@
 #include <numeric>
 #include <math.h>
 
+/** The spectral features computed together by CoreFrequencyDomainFeatures::spectralStatistics() */
+template <class T>
+struct SpectralStatistics
+{
+    T centroid;     /**< the spectral centroid as an index value */
+    T crest;        /**< the spectral crest */
+    T flatness;     /**< the spectral flatness */
+    T rolloff;      /**< the spectral rolloff */
+    T kurtosis;     /**< the spectral kurtosis */
+};
+
 /** template class for calculating common frequency domain
  * audio features. Instantiations of the class should be
  * of either 'float' or 'double' types and no others */
@@ -47,6 +58,13 @@ public:
      */
     T spectralCentroid (const std::vector<T>& magnitudeSpectrum);
 
+    /** calculates the spectral centroid as above, given the already computed sum of the magnitude spectrum
+     @param magnitudeSpectrum the first half of the magnitude spectrum (i.e. not mirrored)
+     @param sumOfMagnitudes the sum of magnitudeSpectrum
+     @returns the spectral centroid as an index value
+     */
+    T spectralCentroid (const std::vector<T>& magnitudeSpectrum, T sumOfMagnitudes);
+
     //===========================================================
     /** calculates the spectral flatness given the first half of the magnitude spectrum
      of an audio signal.
@@ -62,6 +80,13 @@ public:
      @returns the spectral crest
      */
     T spectralCrest (const std::vector<T>& magnitudeSpectrum);
+
+    /** calculates the spectral crest given the first half of the power (squared magnitude) spectrum
+     of an audio signal, which saves squaring the magnitudes again.
+     @param powerSpectrum the first half of the power spectrum (i.e. not mirrored)
+     @returns the spectral crest
+     */
+    T spectralCrestOfPowerSpectrum (const std::vector<T>& powerSpectrum);
     
     //===========================================================
     /** calculates the spectral rolloff given the first half of the magnitude spectrum
@@ -71,6 +96,14 @@ public:
      @returns the spectral rolloff
      */
     T spectralRolloff (const std::vector<T>& magnitudeSpectrum, T percentile = 0.85);
+
+    /** calculates the spectral rolloff as above, given the already computed sum of the magnitude spectrum
+     @param magnitudeSpectrum the first half of the magnitude spectrum (i.e. not mirrored)
+     @param sumOfMagnitudes the sum of magnitudeSpectrum
+     @param percentile the rolloff threshold
+     @returns the spectral rolloff
+     */
+    T spectralRolloff (const std::vector<T>& magnitudeSpectrum, T sumOfMagnitudes, T percentile);
     
     //===========================================================
     /** calculates the spectral kurtosis given the first half of the magnitude spectrum
@@ -79,8 +112,32 @@ public:
      @returns the spectral kurtosis
      */
     T spectralKurtosis (const std::vector<T>& magnitudeSpectrum);
+
+    /** calculates the spectral kurtosis as above, given the already computed mean of the magnitude spectrum
+     @param magnitudeSpectrum the first half of the magnitude spectrum (i.e. not mirrored)
+     @param mean the mean of magnitudeSpectrum
+     @returns the spectral kurtosis
+     */
+    T spectralKurtosis (const std::vector<T>& magnitudeSpectrum, T mean);
+    
+    //===========================================================
+    /** calculates the spectral centroid, crest, flatness, rolloff and kurtosis together
+     in two passes over the first half of the magnitude spectrum, with double accumulators.
+     The results match the individual functions up to rounding.
+     @param magnitudeSpectrum the first half of the magnitude spectrum (i.e. not mirrored)
+     @param rolloffPercentile the rolloff threshold
+     @returns all five features
+     */
+    SpectralStatistics<T> spectralStatistics (const std::vector<T>& magnitudeSpectrum, T rolloffPercentile = 0.85);
+    
+private:
     
+    /** the number of independent accumulators per sum in spectralStatistics(), so that
+     its loops can be vectorized without reordering a single sum */
+    static const int numLanes = 4;
     
+    /** the number of bins multiplied together per lane before taking the logarithm for the flatness */
+    static const int binsPerLogarithm = 8;
 };
 
 #endif
@@ -45,6 +45,15 @@ public:
      */
     T rootMeanSquare (const std::vector<T>& buffer);
 
+    //===========================================================
+    /** calculates the Root Mean Square (RMS) from the sum of squared samples
+     * of an audio buffer
+     * @param sumOfSquares the sum of the squared samples
+     * @param numSamples the number of samples in the buffer
+     * @returns the RMS value
+     */
+    T rootMeanSquare (T sumOfSquares, int numSamples);
+
     //===========================================================
     /** calculates the peak energy (max absolute value) in a time
      * domain audio signal buffer in vector format
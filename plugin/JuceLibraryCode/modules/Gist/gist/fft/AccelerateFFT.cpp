@@ -99,78 +99,124 @@ void AccelerateFFT<double>::setAudioFrameSize (int frameSize)
 template <>
 AccelerateFFT<float>::~AccelerateFFT()
 {
-    free (complexSplit.realp);
-    free (complexSplit.imagp);
-    vDSP_destroy_fftsetup (fftSetupFloat);
+    if (configured)
+    {
+        free (complexSplit.realp);
+        free (complexSplit.imagp);
+        vDSP_destroy_fftsetup (fftSetupFloat);
+    }
 }
 
 //=======================================================================
 template <>
 AccelerateFFT<double>::~AccelerateFFT()
 {
-    free (doubleComplexSplit.realp);
-    free (doubleComplexSplit.imagp);
-    vDSP_destroy_fftsetupD (fftSetupDouble);
+    if (configured)
+    {
+        free (doubleComplexSplit.realp);
+        free (doubleComplexSplit.imagp);
+        vDSP_destroy_fftsetupD (fftSetupDouble);
+    }
 }
 
 //=======================================================================
-template <>
-void AccelerateFFT<float>::performFFT (float* buffer, float* real, float* imag)
+template <class T>
+void AccelerateFFT<T>::performFFT (T* buffer, T* real, T* imag)
 {
-    vDSP_ctoz ((COMPLEX*)buffer, 2, &complexSplit, 1, fftSizeOver2);
-    vDSP_fft_zrip (fftSetupFloat, &complexSplit, 1, log2n, FFT_FORWARD);
-    
-    complexSplit.realp[fftSizeOver2] = complexSplit.imagp[0];
-    complexSplit.imagp[fftSizeOver2] = 0.0;
-    complexSplit.imagp[0] = 0.0;
-    
-    for (size_t i = 0; i <= fftSizeOver2; i++)
-    {
-        complexSplit.realp[i] *= 0.5;
-        complexSplit.imagp[i] *= 0.5;
-    }
+    performHalfSpectrumFFT (buffer, real, imag);
     
+    // the upper half mirrors the lower one as complex conjugates
     for (size_t i = fftSizeOver2 - 1; i > 0; --i)
     {
-        complexSplit.realp[2 * fftSizeOver2 - i] = complexSplit.realp[i];
-        complexSplit.imagp[2 * fftSizeOver2 - i] = -1 * complexSplit.imagp[i];
-    }
-    
-    for (size_t i = 0; i < fftSize; i++)
-    {
-        real[i] = complexSplit.realp[i];
-        imag[i] = complexSplit.imagp[i];
+        real[2 * fftSizeOver2 - i] = real[i];
+        imag[2 * fftSizeOver2 - i] = -1 * imag[i];
     }
 }
 
 //=======================================================================
 template <>
-void AccelerateFFT<double>::performFFT (double* buffer, double* real, double* imag)
+void AccelerateFFT<float>::performHalfSpectrumFFT (float* buffer, float* real, float* imag)
 {
-    vDSP_ctozD ((DOUBLE_COMPLEX*)buffer, 2, &doubleComplexSplit, 1, fftSizeOver2);
-    vDSP_fft_zripD (fftSetupDouble, &doubleComplexSplit, 1, log2n, FFT_FORWARD);
-    
-    doubleComplexSplit.realp[fftSizeOver2] = doubleComplexSplit.imagp[0];
-    doubleComplexSplit.imagp[fftSizeOver2] = 0.0;
-    doubleComplexSplit.imagp[0] = 0.0;
-    
-    for (size_t i = 0; i <= fftSizeOver2; i++)
+    COMPLEX_SPLIT split;
+    split.realp = real;
+    split.imagp = imag;
+    
+    vDSP_ctoz ((COMPLEX*)buffer, 2, &split, 1, fftSizeOver2);
+    vDSP_fft_zrip (fftSetupFloat, &split, 1, log2n, FFT_FORWARD);
+    
+    // vDSP_fft_zrip packs the Nyquist bin into imag[0]
+    real[fftSizeOver2] = imag[0];
+    imag[fftSizeOver2] = 0.0;
+    imag[0] = 0.0;
+    
+    // and its output is scaled by 2 relative to the mathematical FFT
+    float scale = 0.5;
+    vDSP_vsmul (real, 1, &scale, real, 1, fftSizeOver2 + 1);
+    vDSP_vsmul (imag, 1, &scale, imag, 1, fftSizeOver2 + 1);
+}
+
+//=======================================================================
+template <>
+void AccelerateFFT<double>::performHalfSpectrumFFT (double* buffer, double* real, double* imag)
+{
+    DOUBLE_COMPLEX_SPLIT split;
+    split.realp = real;
+    split.imagp = imag;
+    
+    vDSP_ctozD ((DOUBLE_COMPLEX*)buffer, 2, &split, 1, fftSizeOver2);
+    vDSP_fft_zripD (fftSetupDouble, &split, 1, log2n, FFT_FORWARD);
+    
+    // vDSP_fft_zripD packs the Nyquist bin into imag[0]
+    real[fftSizeOver2] = imag[0];
+    imag[fftSizeOver2] = 0.0;
+    imag[0] = 0.0;
+    
+    // and its output is scaled by 2 relative to the mathematical FFT
+    double scale = 0.5;
+    vDSP_vsmulD (real, 1, &scale, real, 1, fftSizeOver2 + 1);
+    vDSP_vsmulD (imag, 1, &scale, imag, 1, fftSizeOver2 + 1);
+}
+
+//=======================================================================
+template <>
+void AccelerateFFT<float>::performInverseFFT (float* real, float* imag, float* buffer)
+{
+    // pack back into the vDSP_fft_zrip layout, Nyquist in imag[0]
+    for (size_t i = 0; i < fftSizeOver2; i++)
     {
-        doubleComplexSplit.realp[i] *= 0.5;
-        doubleComplexSplit.imagp[i] *= 0.5;
+        complexSplit.realp[i] = real[i];
+        complexSplit.imagp[i] = imag[i];
     }
     
-    for (size_t i = fftSizeOver2 - 1; i > 0; --i)
-    {
-        doubleComplexSplit.realp[2 * fftSizeOver2 - i] = doubleComplexSplit.realp[i];
-        doubleComplexSplit.imagp[2 * fftSizeOver2 - i] = -1 * doubleComplexSplit.imagp[i];
-    }
+    complexSplit.imagp[0] = real[fftSizeOver2];
+    
+    vDSP_fft_zrip (fftSetupFloat, &complexSplit, 1, log2n, FFT_INVERSE);
+    vDSP_ztoc (&complexSplit, 1, (COMPLEX*)buffer, 2, fftSizeOver2);
     
-    for (size_t i = 0; i < fftSize; i++)
+    // the inverse transform is scaled by N relative to the mathematical one
+    float scale = 1.0 / fftSize;
+    vDSP_vsmul (buffer, 1, &scale, buffer, 1, fftSize);
+}
+
+//=======================================================================
+template <>
+void AccelerateFFT<double>::performInverseFFT (double* real, double* imag, double* buffer)
+{
+    // pack back into the vDSP_fft_zrip layout, Nyquist in imag[0]
+    for (size_t i = 0; i < fftSizeOver2; i++)
     {
-        real[i] = doubleComplexSplit.realp[i];
-        imag[i] = doubleComplexSplit.imagp[i];
+        doubleComplexSplit.realp[i] = real[i];
+        doubleComplexSplit.imagp[i] = imag[i];
     }
+    
+    doubleComplexSplit.imagp[0] = real[fftSizeOver2];
+    
+    vDSP_fft_zripD (fftSetupDouble, &doubleComplexSplit, 1, log2n, FFT_INVERSE);
+    vDSP_ztocD (&doubleComplexSplit, 1, (DOUBLE_COMPLEX*)buffer, 2, fftSizeOver2);
+    
+    // the inverse transform is scaled by N relative to the mathematical one
+    double scale = 1.0 / fftSize;
+    vDSP_vsmulD (buffer, 1, &scale, buffer, 1, fftSize);
 }
 
 //===========================================================
@@ -44,9 +44,18 @@ public:
     /** Sets the audio frame size to be used in the FFT */
     void setAudioFrameSize (int frameSize);
     
-    /** Performs the FFT using Apple Accelerate FFT */
+    /** Performs the FFT using Apple Accelerate FFT, writing the full (mirrored) spectrum */
     void performFFT (T* buffer, T* real, T* imag);
     
+    /** Performs the FFT using Apple Accelerate FFT, transforming in place in real and imag,
+     * which must hold N/2 + 1 values and receive bins 0 .. N/2 */
+    void performHalfSpectrumFFT (T* buffer, T* real, T* imag);
+    
+    /** Performs the inverse FFT using Apple Accelerate FFT. Takes a spectrum in
+     * the layout performFFT() produces, of which only bins 0 .. N/2 are read, and
+     * writes the real time domain signal to buffer */
+    void performInverseFFT (T* real, T* imag, T* buffer);
+    
 private:
     
     size_t fftSize;
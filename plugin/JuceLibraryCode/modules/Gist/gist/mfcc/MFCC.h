@@ -85,13 +85,13 @@ private:
      */
     void initialise();
 
-    /** Calculates the discrete cosine transform (version 2) of an input signal, performing it in place
-     * (i.e. the result is stored in the vector passed to the function)
+    /** Calculates the discrete cosine transform (version 2) of an input signal with the
+     * precomputed dctMatrix
      *
-     * @param inputSignal a vector containing the input signal
-     * @param numElements the number of elements in the input signal
+     * @param inputSignal a vector containing the input signal, numCoefficents long
+     * @param outputSignal a vector to hold the result, numCoefficents long
      */
-    void discreteCosineTransform (std::vector<T>& inputSignal, const size_t numElements);
+    void discreteCosineTransform (const std::vector<T>& inputSignal, std::vector<T>& outputSignal);
 
     /** Calculates the triangular filters used in the algorithm. These will be different depending
      * upon the frame size, sampling frequency and number of coefficients and so should be re-calculated
@@ -99,6 +99,9 @@ private:
      */
     void calculateMelFilterBank();
 
+    /** Calculates the DCT-II matrix for the current number of coefficients */
+    void calculateDCTMatrix();
+
     /** Calculates mel from frequency
      * @param frequency the frequency in Hz
      * @returns the equivalent mel value
@@ -123,8 +126,22 @@ private:
     /** the maximum frequency to be used in the calculation of MFCCs */
     T maxFrequency;
 
-    /** a vector of vectors to hold the values of the triangular filters */
-    std::vector<std::vector<T> > filterBank;
+    /** the first magnitude spectrum bin covered by each triangular filter */
+    std::vector<int> filterStart;
+
+    /** the values of each triangular filter from its first bin, leaving out the bins
+     where the filter is zero */
+    std::vector<std::vector<T> > filterWeights;
+
+    /** the DCT-II matrix, row k holding 2 * cos (pi / N * (n + 0.5) * k) for n = 0..N-1 */
+    std::vector<T> dctMatrix;
+
+    /** a vector to hold the log mel spectrum before the DCT */
+    std::vector<T> logMelSpectrum;
+
+    /** the number of independent sums per dot product, so that the filterbank and DCT
+     loops can be vectorized without reordering a single sum */
+    static const int numLanes = 4;
 };
 
 #endif /* defined(__GIST__MFCC__) */
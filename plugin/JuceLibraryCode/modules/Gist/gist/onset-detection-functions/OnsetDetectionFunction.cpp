@@ -38,8 +38,10 @@ void OnsetDetectionFunction<T>::setFrameSize (int frameSize)
     // resize the prev magnitude spectrum vector
     prevMagnitudeSpectrum_spectralDifference.resize (frameSize);
     prevMagnitudeSpectrum_spectralDifferenceHWR.resize (frameSize);
-    prevPhaseSpectrum_complexSpectralDifference.resize (frameSize);
-    prevPhaseSpectrum2_complexSpectralDifference.resize (frameSize);
+    prevPhasorReal_complexSpectralDifference.resize (frameSize);
+    prevPhasorImag_complexSpectralDifference.resize (frameSize);
+    prevPhasor2Real_complexSpectralDifference.resize (frameSize);
+    prevPhasor2Imag_complexSpectralDifference.resize (frameSize);
     prevMagnitudeSpectrum_complexSpectralDifference.resize (frameSize);
 
     // fill it with zeros
@@ -47,8 +49,10 @@ void OnsetDetectionFunction<T>::setFrameSize (int frameSize)
     {
         prevMagnitudeSpectrum_spectralDifference[i] = 0.0;
         prevMagnitudeSpectrum_spectralDifferenceHWR[i] = 0.0;
-        prevPhaseSpectrum_complexSpectralDifference[i] = 0.0;
-        prevPhaseSpectrum2_complexSpectralDifference[i] = 0.0;
+        prevPhasorReal_complexSpectralDifference[i] = 1.0; // zero phase
+        prevPhasorImag_complexSpectralDifference[i] = 0.0;
+        prevPhasor2Real_complexSpectralDifference[i] = 1.0;
+        prevPhasor2Imag_complexSpectralDifference[i] = 0.0;
         prevMagnitudeSpectrum_complexSpectralDifference[i] = 0.0;
     }
 
@@ -63,7 +67,6 @@ template <class T>
 T OnsetDetectionFunction<T>::energyDifference (const std::vector<T>& buffer)
 {
     T sum;
-    T difference;
 
     sum = 0; // initialise sum
 
@@ -73,9 +76,18 @@ T OnsetDetectionFunction<T>::energyDifference (const std::vector<T>& buffer)
         sum = sum + (buffer[i] * buffer[i]);
     }
 
-    difference = sum - prevEnergySum; // sample is first order difference in energy
+    return energyDifference (sum);
+}
+
+//===========================================================
+template <class T>
+T OnsetDetectionFunction<T>::energyDifference (T energy)
+{
+    T difference;
+
+    difference = energy - prevEnergySum; // sample is first order difference in energy
 
-    prevEnergySum = sum; // store energy value for next calculation
+    prevEnergySum = energy; // store energy value for next calculation
 
     if (difference > 0)
     {
@@ -143,49 +155,42 @@ T OnsetDetectionFunction<T>::spectralDifferenceHWR (const std::vector<T>& magnit
 template <class T>
 T OnsetDetectionFunction<T>::complexSpectralDifference (const std::vector<T>& fftReal, const std::vector<T>& fftImag)
 {
-    T dev, pdev;
-    T sum;
-    T magDiff, phaseDiff;
-    T value;
-    T phaseVal;
-    T magVal;
+    // the spectrum of a real signal mirrors around N/2: bin N - k is the conjugate
+    // of bin k, which gives the same term, so every bin strictly between 0 and N/2
+    // is counted twice
+    const int nyquistBin = (int)fftReal.size() - 1;
 
-    sum = 0; // initialise sum to zero
+    T edgeSum = complexSpectralDifferenceBin (fftReal[0], fftImag[0], 0);
 
-    // compute phase values from fft output and sum deviations
-    for (int i = 0; i < fftReal.size(); i++)
+    if (nyquistBin > 0)
     {
-        // calculate phase value
-        phaseVal = atan2 (fftImag[i], fftReal[i]);
-
-        // calculate magnitude value
-        magVal = sqrt ((fftReal[i] * fftReal[i]) + (fftImag[i] * fftImag[i]));
-
-        // phase deviation
-        dev = phaseVal - (2 * prevPhaseSpectrum_complexSpectralDifference[i]) + prevPhaseSpectrum2_complexSpectralDifference[i];
-
-        // wrap into [-pi,pi] range
-        pdev = princarg (dev);
+        edgeSum = edgeSum + complexSpectralDifferenceBin (fftReal[nyquistBin], fftImag[nyquistBin], nyquistBin);
+    }
 
-        // calculate magnitude difference (real part of Euclidean distance between complex frames)
-        magDiff = magVal - prevMagnitudeSpectrum_complexSpectralDifference[i];
+    T laneSums[numLanes] = {};
+    int i = 1;
 
-        // calculate phase difference (imaginary part of Euclidean distance between complex frames)
-        phaseDiff = -magVal * sin (pdev);
+    for (; i + numLanes <= nyquistBin; i += numLanes)
+    {
+        for (int j = 0; j < numLanes; j++)
+        {
+            laneSums[j] += complexSpectralDifferenceBin (fftReal[i + j], fftImag[i + j], i + j);
+        }
+    }
 
-        // square real and imaginary parts, sum and take square root
-        value = sqrt ((magDiff * magDiff) + (phaseDiff * phaseDiff));
+    for (; i < nyquistBin; i++)
+    {
+        laneSums[0] += complexSpectralDifferenceBin (fftReal[i], fftImag[i], i);
+    }
 
-        // add to sum
-        sum = sum + value;
+    T sum = 0;
 
-        // store values for next calculation
-        prevPhaseSpectrum2_complexSpectralDifference[i] = prevPhaseSpectrum_complexSpectralDifference[i];
-        prevPhaseSpectrum_complexSpectralDifference[i] = phaseVal;
-        prevMagnitudeSpectrum_complexSpectralDifference[i] = magVal;
+    for (int j = 0; j < numLanes; j++)
+    {
+        sum = sum + laneSums[j];
     }
 
-    return sum;
+    return edgeSum + (2 * sum);
 }
 
 //===========================================================
@@ -206,21 +211,44 @@ T OnsetDetectionFunction<T>::highFrequencyContent (const std::vector<T>& magnitu
 
 //===========================================================
 template <class T>
-T OnsetDetectionFunction<T>::princarg (T phaseVal)
+T OnsetDetectionFunction<T>::complexSpectralDifferenceBin (T real, T imag, int bin)
 {
-    // if phase value is less than or equal to -pi then add 2*pi
-    while (phaseVal <= (-M_PI))
-    {
-        phaseVal = phaseVal + (2 * M_PI);
-    }
-
-    // if phase value is larger than pi, then subtract 2*pi
-    while (phaseVal > M_PI)
-    {
-        phaseVal = phaseVal - (2 * M_PI);
-    }
-
-    return phaseVal;
+    // calculate magnitude value
+    T magVal = sqrt ((real * real) + (imag * imag));
+
+    // the phase as a unit phasor, with atan2 (0, 0) = 0 for a zero bin
+    T inverseMag = magVal > 0 ? 1 / magVal : 0;
+    T phasorReal = magVal > 0 ? real * inverseMag : 1;
+    T phasorImag = imag * inverseMag;
+
+    T prevReal = prevPhasorReal_complexSpectralDifference[bin];
+    T prevImag = prevPhasorImag_complexSpectralDifference[bin];
+    T prev2Real = prevPhasor2Real_complexSpectralDifference[bin];
+    T prev2Imag = prevPhasor2Imag_complexSpectralDifference[bin];
+
+    // the phase deviation, phase - 2 * prevPhase + prev2Phase, is the angle of
+    // bin * conj (prevPhasor)^2 * prev2Phasor, which has the bin's magnitude. Its
+    // imaginary part is magVal * sin (deviation), without atan2, sin or wrapping
+    T predictedReal = (prevReal * prevReal) - (prevImag * prevImag);
+    T predictedImag = -2 * prevReal * prevImag;
+    T rotationReal = (predictedReal * prev2Real) - (predictedImag * prev2Imag);
+    T rotationImag = (predictedReal * prev2Imag) + (predictedImag * prev2Real);
+
+    // calculate magnitude difference (real part of Euclidean distance between complex frames)
+    T magDiff = magVal - prevMagnitudeSpectrum_complexSpectralDifference[bin];
+
+    // calculate phase difference (imaginary part of Euclidean distance between complex frames)
+    T phaseDiff = -((real * rotationImag) + (imag * rotationReal));
+
+    // store values for next calculation
+    prevPhasor2Real_complexSpectralDifference[bin] = prevReal;
+    prevPhasor2Imag_complexSpectralDifference[bin] = prevImag;
+    prevPhasorReal_complexSpectralDifference[bin] = phasorReal;
+    prevPhasorImag_complexSpectralDifference[bin] = phasorImag;
+    prevMagnitudeSpectrum_complexSpectralDifference[bin] = magVal;
+
+    // square real and imaginary parts and take square root
+    return sqrt ((magDiff * magDiff) + (phaseDiff * phaseDiff));
 }
 
 //===========================================================
@@ -53,6 +53,14 @@ public:
      */
     T energyDifference (const std::vector<T>& buffer);
 
+    //===========================================================
+    /** calculates the energy difference onset detection function
+     * from the energy of the audio frame
+     * @param energy the sum of the squared samples of the frame
+     * @returns the energy difference onset detection function sample for the frame
+     */
+    T energyDifference (T energy);
+
     //===========================================================
     /** calculates the spectral difference between the current magnitude
      * spectrum and the previous magnitude spectrum
@@ -71,9 +79,10 @@ public:
 
     //===========================================================
     /** calculates the complex spectral difference from the real and imaginary parts 
-     * of the FFT
-     * @param fftReal a vector containing the real part of the FFT
-     * @param fftImag a vector containing the imaginary part of the FFT
+     * of the FFT of a real signal, given as bins 0 to N/2 (i.e. not mirrored). The
+     * mirrored bins are accounted for by symmetry
+     * @param fftReal a vector containing the real part of the FFT, N/2 + 1 bins
+     * @param fftImag a vector containing the imaginary part of the FFT, N/2 + 1 bins
      * @returns the complex spectral difference onset detection function sample
      */
     T complexSpectralDifference (const std::vector<T>& fftReal, const std::vector<T>& fftImag);
@@ -87,8 +96,17 @@ public:
     T highFrequencyContent (const std::vector<T>& magnitudeSpectrum);
 
 private:
-    /** maps phasein into the [-pi:pi] range */
-    T princarg (T phaseVal);
+    /** calculates one bin's complex spectral difference term and stores the bin's
+     * magnitude and phase direction for the next frame
+     * @param real the real part of the bin
+     * @param imag the imaginary part of the bin
+     * @param bin the bin index
+     */
+    T complexSpectralDifferenceBin (T real, T imag, int bin);
+
+    /** the number of independent sums in complexSpectralDifference(), so that
+     * its loop can be vectorized without reordering a single sum */
+    static const int numLanes = 4;
 
     //===========================================================
     /** holds the previous energy sum for the energy difference onset detection function */
@@ -102,13 +120,15 @@ private:
      last spectral difference (half wave rectified) call */
     std::vector<T> prevMagnitudeSpectrum_spectralDifferenceHWR;
 
-    /** a vector containing the previous phase spectrum passed to the
-     last complex spectral difference call */
-    std::vector<T> prevPhaseSpectrum_complexSpectralDifference;
+    /** vectors containing the previous phases passed to the last complex spectral
+     difference call, as the real and imaginary parts of unit length phasors */
+    std::vector<T> prevPhasorReal_complexSpectralDifference;
+    std::vector<T> prevPhasorImag_complexSpectralDifference;
 
-    /** a vector containing the second previous phase spectrum passed to the
-     last complex spectral difference call */
-    std::vector<T> prevPhaseSpectrum2_complexSpectralDifference;
+    /** vectors containing the second previous phases passed to the last complex
+     spectral difference call, as unit length phasors */
+    std::vector<T> prevPhasor2Real_complexSpectralDifference;
+    std::vector<T> prevPhasor2Imag_complexSpectralDifference;
 
     /** a vector containing the previous magnitude spectrum passed to the
      last complex spectral difference call */
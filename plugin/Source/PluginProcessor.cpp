@@ -35,12 +35,14 @@ AudioProcessor* JUCE_CALLTYPE createPluginFilter();
 JuceDemoPluginAudioProcessor::JuceDemoPluginAudioProcessor()
     : AudioProcessor (getBusesProperties()),
       lastUIWidth (400),
-      lastUIHeight (200)
+      lastUIHeight (200),
+      analysisFrameFill (0)
 {
     lastPosInfo.resetToDefault();
     
     rmsThreshold = -50.0;
     silenceThreshold = 22050;
+    started = false;
 }
 
 JuceDemoPluginAudioProcessor::~JuceDemoPluginAudioProcessor()
@@ -77,6 +79,20 @@ void JuceDemoPluginAudioProcessor::prepareToPlay (double newSampleRate, int /*sa
 {
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
+    gist = new Gist<float> (analysisFrameSize, (int) newSampleRate);
+    
+    // Only what processFeatures() and the editor use; the onset detection
+    // functions are never read
+    gist->setFeatureMask (PitchFeature | RootMeanSquareFeature | PeakEnergyFeature
+                          | ZeroCrossingRateFeature | SpectralCentroidFeature | SpectralCrestFeature
+                          | SpectralFlatnessFeature | SpectralRolloffFeature | SpectralKurtosisFeature);
+    
+    // Also plans Yin's FFT for the shorter lag range, off the audio thread
+    gist->setPitchRange (minPitch, maxPitchSearch);
+    
+    analysisFrame.assign (analysisFrameSize, 0.0f);
+    analysisFrameFill = 0;
+    started = false;
 }
 
 void JuceDemoPluginAudioProcessor::releaseResources()
@@ -89,27 +105,29 @@ void JuceDemoPluginAudioProcessor::reset()
 {
     // Use this method as the place to clear any delay lines, buffers, etc, as it
     // means there's been a break in the audio's continuity.
+    analysisFrameFill = 0;
 }
 
 void JuceDemoPluginAudioProcessor::analyze(const float * buffer, const int numSamples, gistResults *g) {
-    Gist<float> gist(numSamples, 44100);
-    gist.processAudioFrame(buffer, numSamples);
+    gist->processAudioFrame(buffer, numSamples);
     
-    g->f0 = gist.pitch();
-    g->rms = gist.rootMeanSquare();
+    g->f0 = gist->pitch();
+    g->rms = gist->rootMeanSquare();
     g->rmsDB = Decibels::gainToDecibels(g->rms);
-    g->peakEnergy = gist.peakEnergy();
-    g->zeroCrossings = gist.zeroCrossingRate();
-    g->spectralCentroid = gist.spectralCentroid();
-    g->spectralCrest = gist.spectralCrest();
-    g->spectralFlatness = gist.spectralFlatness();
-    g->spectralRolloff = gist.spectralRolloff();
-    g->spectralKurtosis = gist.spectralKurtosis();
-    g->energyDifference = gist.energyDifference();
-    g->spectralDifference = gist.spectralDifference();
-    g->spectralDifferenceHalfWaveRectified = gist.spectralDifferenceHWR();
-    g->complexSpectralDifference = gist.complexSpectralDifference();
-    g->highFrequencyContent = gist.highFrequencyContent();
+    g->peakEnergy = gist->peakEnergy();
+    g->zeroCrossings = gist->zeroCrossingRate();
+    g->spectralCentroid = gist->spectralCentroid();
+    g->spectralCrest = gist->spectralCrest();
+    g->spectralFlatness = gist->spectralFlatness();
+    g->spectralRolloff = gist->spectralRolloff();
+    g->spectralKurtosis = gist->spectralKurtosis();
+    
+    // Not in the feature mask
+    g->energyDifference = 0.0f;
+    g->spectralDifference = 0.0f;
+    g->spectralDifferenceHalfWaveRectified = 0.0f;
+    g->complexSpectralDifference = 0.0f;
+    g->highFrequencyContent = 0.0f;
 }
 
 static String timeToTimecodeString (double seconds)
@@ -145,10 +163,39 @@ void JuceDemoPluginAudioProcessor::processBlock(AudioBuffer<float>& buffer, Midi
     for (int i = getTotalNumInputChannels(); i < getTotalNumOutputChannels(); ++i)
         buffer.clear (i, 0, numSamples);
     
-    // Retrive this blocks audio features and place them in g.
-    gistResults g;
-    analyze((const float*)buffer.getReadPointer(0), numSamples, &g);
+    // Not prepared yet: nothing to analyze with
+    if (gist == nullptr) {
+        updateCurrentTimeInfoFromHost();
+        return;
+    }
     
+    // Accumulate the block into analysis frames; every completed frame is
+    // analyzed, however the host sizes its blocks.
+    const float* input = buffer.getReadPointer(0);
+    int consumed = 0;
+    
+    while (consumed < numSamples) {
+        const int count = jmin(numSamples - consumed, analysisFrameSize - analysisFrameFill);
+        std::copy(input + consumed, input + consumed + count, analysisFrame.begin() + analysisFrameFill);
+        analysisFrameFill += count;
+        consumed += count;
+        
+        if (analysisFrameFill == analysisFrameSize) {
+            // Retrive this frame's audio features and place them in g.
+            gistResults g;
+            analyze(analysisFrame.data(), analysisFrameSize, &g);
+            processFeatures(g, analysisFrameSize);
+            analysisFrameFill = 0;
+        }
+    }
+    
+    // Update time.
+    updateCurrentTimeInfoFromHost();
+}
+
+// Runs the start / accumulate / post state machine on one analysis frame.
+void JuceDemoPluginAudioProcessor::processFeatures(const gistResults& g, const int numSamples)
+{
     if (!started && g.rmsDB >= rmsThreshold) {
         // If we haven't detected an audio file previously,
         // but rms exceeds threshold for silence, start accumulating feature values.
@@ -177,7 +224,7 @@ void JuceDemoPluginAudioProcessor::processBlock(AudioBuffer<float>& buffer, Midi
         silenceHeard += numSamples;
         blocksHeard += 1;
         
-        if (g.f0 >= 60.0 && g.f0 <= 600.0 )
+        if (g.f0 >= minPitch && g.f0 <= maxPitch)
             accum_f0 += g.f0;
         
         accum_rms += g.rmsDB;
@@ -210,8 +257,6 @@ void JuceDemoPluginAudioProcessor::processBlock(AudioBuffer<float>& buffer, Midi
         
         started = false;
     }
-    // Update time.
-    updateCurrentTimeInfoFromHost();
 }
 
 double JuceDemoPluginAudioProcessor::getTimeInSeconds() {
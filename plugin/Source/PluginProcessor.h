@@ -205,8 +205,18 @@ public:
     void setStateInformation (const void* data, int sizeInBytes) override;
     void post(juce::String url, juce::String endpoint);
     void analyze(const float * buffer, const int numSamples, gistResults *g);
+    void processFeatures(const gistResults& g, const int numSamples);
     double getTimeInSeconds();
     
+    // Samples per analysis frame, independent of the host's block size
+    static const int analysisFrameSize = 2048;
+    
+    // f0 values processFeatures() accumulates. Yin searches up to maxPitchSearch
+    // so a higher note is rejected rather than read an octave low.
+    static constexpr float minPitch = 60.0f;
+    static constexpr float maxPitch = 600.0f;
+    static constexpr float maxPitchSearch = 1500.0f;
+    
     AudioPlayHead::CurrentPositionInfo lastPosInfo;
     
     String startedAt, endedAt;
@@ -221,6 +231,14 @@ public:
     double startedTime, endedTime;
     
 private:
+    // Created in prepareToPlay() so the audio thread never allocates, and kept
+    // across frames so the onset detection functions see the previous frame
+    ScopedPointer<Gist<float>> gist;
+    
+    // Input accumulated until a full analysis frame is available
+    std::vector<float> analysisFrame;
+    int analysisFrameFill;
+    
     void updateCurrentTimeInfoFromHost();
     static BusesProperties getBusesProperties();
 